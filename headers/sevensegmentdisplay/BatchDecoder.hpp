@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct SegmentRun
+{
+    uint64_t start;
+    uint8_t segments;
+};
+
+// Headless decode of a whole trace through digitToSegments.
+// Inputs ending in .vcd are read as VCD, anything else as raw samples (one byte per sample, low nibble).
+// The trace is processed in windows of parallel chunks and written out as it goes, so memory stays bounded.
+class BatchDecoder
+{
+public:
+    static constexpr size_t chunkBytes = 4 * 1024 * 1024;
+    static constexpr unsigned chunksPerThread = 4;
+
+    BatchDecoder(const std::string& input, const std::string& signal, unsigned threads, const std::string& format, std::ostream& out);
+
+    void run();
+    // Raw inputs count every sample, VCD inputs only the value changes of the signal
+    [[nodiscard]] uint64_t getSamples() const;
+    [[nodiscard]] const char* getSampleUnit() const;
+    [[nodiscard]] uint64_t getBytes() const;
+    [[nodiscard]] uint64_t getRunCount() const;
+    [[nodiscard]] double getSeconds() const;
+
+private:
+    void decodeRaw();
+    void decodeVcd();
+    void emit(std::vector<std::vector<SegmentRun>>& chunks);
+    void writeHeader();
+    void writeRun(const SegmentRun& run);
+    void writeFooter();
+
+    std::string input;
+    std::string signal;
+    unsigned threads;
+    bool vcdInput;
+    bool vcdOutput;
+    std::ostream& out;
+    std::string buffer;
+    SegmentRun last{0, 0xFF};
+    uint64_t runCount = 0;
+    uint64_t endTime = 0;
+    uint64_t samples = 0;
+    uint64_t bytes = 0;
+    double timescale = 1e-9;
+    double seconds = 0;
+};
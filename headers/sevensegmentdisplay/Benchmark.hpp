@@ -0,0 +1,17 @@
+#pragma once
+
+#include "sevensegmentdisplay/RenderBackend.hpp"
+
+#include <cstdint>
+#include <string>
+
+// Runs the same synthetic workload through one or more render backends and compares frame cost
+class Benchmark
+{
+public:
+    // backend is a backend name, a comma separated list of names, or "all"
+    static int run(const std::string& backend, uint64_t frames, RenderSettings settings);
+    // Renders the same frames with the sine and the integer noise kernel on a GL backend,
+    // then prints the frame cost of each and how close the final images are
+    static int compareNoise(const std::string& backend, uint64_t frames, RenderSettings settings);
+};
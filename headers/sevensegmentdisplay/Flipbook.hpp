@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// On-disk cache of a baked background loop: BC4 (RGTC1) compressed R8 layers, memory-mapped when loaded.
+// Files live in RenderBackend::getCacheDirectory() and are named after the size, layer count and shader hash,
+// so a changed shader or window size bakes a new file instead of reading a stale one.
+//
+// The renderer cross-fades the two layers around the current time, which only reproduces the animation when
+// adjacent layers are close enough to be correlated. With fewer than correlatedLayers() the frames between layers
+// are blends of two different patterns, so --flipbook refuses smaller counts; the bake reports how far the
+// frames between layers are from the live render.
+class Flipbook
+{
+public:
+    // Every sin() in pattern() runs at a multiple of time * 0.00005, so the background repeats after this many frames
+    static constexpr double period = 40000.0 * std::numbers::pi;
+    // Fastest drift in pattern(): aPos.y = sin(time / 20 * 0.01) * 6 moves up to 0.003 lattice units per frame
+    static constexpr double maxDriftPerFrame = 6.0 * 0.01 / 20.0;
+    // Drift between adjacent layers up to which the cross-fade still resembles the animation
+    static constexpr double maxLayerDrift = 0.25;
+
+    // Maps an existing cache file; throws runtime_error when it is missing or does not match
+    Flipbook(const std::string& path, int width, int height, int layers, uint64_t shaderHash);
+    ~Flipbook();
+    Flipbook(const Flipbook&) = delete;
+    Flipbook& operator=(const Flipbook&) = delete;
+
+    static std::string cachePath(int width, int height, int layers, uint64_t shaderHash);
+    // FNV-1a, stable across builds so cache names survive a rebuild
+    static uint64_t hash(std::string_view text);
+    // Width and height must be multiples of 4
+    static size_t layerBytes(int width, int height);
+    static void compressLayer(const uint8_t* pixels, int width, int height, uint8_t* blocks);
+    static void decompressLayer(const uint8_t* blocks, int width, int height, uint8_t* pixels);
+    // Decompresses blocks and throws runtime_error for any texel further from pixels than the BC4 error bound of
+    // its block allows; returns the sum of squared errors
+    static double checkRoundTrip(const uint8_t* pixels, const uint8_t* blocks, int width, int height);
+    // Layers needed to keep the drift between adjacent layers within maxLayerDrift
+    static int correlatedLayers();
+    // Written to a temporary file and renamed, so a reader never maps a half-written cache
+    static void write(const std::string& path, int width, int height, int layers, uint64_t shaderHash, const std::vector<uint8_t>& blocks);
+
+    // All layers back to back, layerBytes() each
+    [[nodiscard]] const uint8_t* getBlocks() const;
+    [[nodiscard]] size_t getSize() const;
+
+private:
+    struct Header
+    {
+        char magic[8];
+        uint32_t width;
+        uint32_t height;
+        uint32_t layers;
+        uint32_t reserved;
+        uint64_t shaderHash;
+    };
+
+    static Header makeHeader(int width, int height, int layers, uint64_t shaderHash);
+
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Captures rendered frames through a ring of pixel buffer objects guarded by fences and
+// encodes them on worker threads. When the encoders fall behind frames are dropped, never waited for.
+class FrameExporter
+{
+public:
+    enum class Format
+    {
+        Y4m,
+        Rgba,
+        Png,
+        Apng
+    };
+
+    static constexpr size_t ringSize = 3;
+    static constexpr size_t maxQueuedFrames = 8;
+
+    FrameExporter(const std::string& path, Format format, int width, int height, int fps, unsigned workers);
+    ~FrameExporter();
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+
+    static Format formatFromName(const std::string& name);
+
+    void capture();
+    void finish();
+    [[nodiscard]] uint64_t getCaptured() const;
+    [[nodiscard]] uint64_t getDropped() const;
+    // Frames, or the closing write of a single-file export, that did not reach the disk
+    [[nodiscard]] uint64_t getFailed() const;
+    [[nodiscard]] double getAverageCaptureMs() const;
+
+private:
+    struct Slot
+    {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        uint64_t index = 0;
+    };
+
+    struct Job
+    {
+        uint64_t index;
+        std::vector<uint8_t> pixels;
+    };
+
+    void collect(Slot& slot);
+    void work();
+    std::vector<uint8_t> encode(const std::vector<uint8_t>& pixels) const;
+    void writeOrdered(uint64_t index, std::vector<uint8_t> encoded);
+    void writeHeader();
+    void writeChunk(const char* type, const uint8_t* payload, size_t size);
+
+    std::string path;
+    Format format;
+    int width;
+    int height;
+    int fps;
+    std::array<Slot, ringSize> slots{};
+    uint64_t frameIndex = 0;
+    uint64_t captured = 0;
+    uint64_t dropped = 0;
+    uint64_t failed = 0;
+    double captureSeconds = 0;
+
+    std::mutex mutex;
+    // Serializes the ordered writes to out, so mutex is never held across disk I/O
+    std::mutex writeMutex;
+    std::condition_variable available;
+    std::deque<Job> jobs;
+    std::vector<std::vector<uint8_t>> pool;
+    std::map<uint64_t, std::vector<uint8_t>> ready;
+    uint64_t nextToWrite = 0;
+    uint32_t apngSequence = 0;
+    uint32_t apngFrames = 0;
+    std::streampos actlPosition{};
+    bool stopping = false;
+    std::ofstream out;
+    std::vector<std::thread> threads;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <type_traits>
+
+// Records every GL call made through the glad pointer table, with its arguments and the data behind them, so
+// ssd_gl_replay can issue the same command stream without the renderer's CPU work. Enabled at runtime with
+// --gl-capture; like the profiler it swaps the glad pointers and needs no changes at the call sites.
+//
+// File layout, native byte order: the magic, context version (gl33, gl45 or gles30), window size and the
+// names of the captured functions, then one record per call. A record is the function index followed by its
+// arguments in order; pointer arguments are a size and that many bytes, or one of the markers below. Output
+// pointers get their size before the call and their contents after it, then comes the return value if any.
+class GlCapture
+{
+public:
+    static constexpr char magic[8] = {'S', 'S', 'D', 'G', 'L', 'C', 'A', '1'};
+    // Pointer argument markers
+    static constexpr uint64_t pointerNull = ~0ull;
+    // An offset into a bound buffer, stored as the next 8 bytes
+    static constexpr uint64_t pointerOffset = ~1ull;
+    // Record indices past the function table
+    static constexpr uint16_t frameRecord = 0xFFFF;
+    // Contents of a write-mapped range when it is bound or unmapped: buffer, offset, size, then the bytes
+    static constexpr uint16_t mappedWriteRecord = 0xFFFE;
+
+    // Wraps every non-null glad pointer; call once all entry points are resolved
+    static void install(const std::string& path, const std::string& context, int width, int height);
+    static bool isInstalled();
+    // Marks the end of a presented frame, the unit ssd_gl_replay loops over
+    static void endFrame();
+
+    static uint16_t registerFunction(const char* name);
+    static void beginCall(uint16_t function, std::span<const uint64_t> args);
+    static void endCall(uint16_t function, std::span<const uint64_t> args, uint64_t result);
+    static void write(const void* data, size_t size);
+    // Bytes behind a pointer argument, or one of the markers; throws for pointers it does not know how to size
+    static uint64_t inputSize(uint16_t function, size_t argument, std::span<const uint64_t> args);
+    static uint64_t outputSize(uint16_t function, size_t argument, std::span<const uint64_t> args);
+    // glShaderSource: the number of strings, then each one with a 4-byte length; the lengths argument is dropped
+    static void writeStrings(uint16_t function, size_t argument, std::span<const uint64_t> args);
+};
+
+template <typename T>
+constexpr bool isGlFunctionPointer = std::is_pointer_v<T> && std::is_function_v<std::remove_pointer_t<T>>;
+
+template <typename T>
+uint64_t toCaptureValue(const T value)
+{
+    if constexpr (std::is_pointer_v<T>) return reinterpret_cast<uintptr_t>(value);
+    else if constexpr (std::is_floating_point_v<T>) return 0;
+    else return static_cast<uint64_t>(value);
+}
+
+// One wrapper per entry point, keyed by the address of its glad pointer
+template <auto* Slot, typename Function = std::remove_pointer_t<decltype(Slot)>>
+struct GlCaptureHook;
+
+template <auto* Slot, typename Result, typename... Args>
+struct GlCaptureHook<Slot, Result (APIENTRYP)(Args...)>
+{
+    static inline Result (APIENTRYP original)(Args...) = nullptr;
+    static inline uint16_t index = 0;
+
+    template <typename T>
+    static void writeArgument(const T value, const size_t argument, const std::span<const uint64_t> args)
+    {
+        if constexpr (isGlFunctionPointer<T>)
+        {
+            // Callbacks cannot be replayed
+        }
+        else if constexpr (std::is_same_v<T, GLsync>)
+        {
+            GlCapture::write(&args[argument], sizeof(uint64_t));
+        }
+        else if constexpr (std::is_same_v<T, const GLchar* const*>)
+        {
+            GlCapture::writeStrings(index, argument, args);
+        }
+        else if constexpr (std::is_pointer_v<T> && std::is_const_v<std::remove_pointer_t<T>>)
+        {
+            const uint64_t size = value ? GlCapture::inputSize(index, argument, args) : GlCapture::pointerNull;
+            GlCapture::write(&size, sizeof(size));
+            if (size == GlCapture::pointerOffset) GlCapture::write(&args[argument], sizeof(uint64_t));
+            else if (size != GlCapture::pointerNull) GlCapture::write(value, size);
+        }
+        else if constexpr (std::is_pointer_v<T>)
+        {
+            const uint64_t size = value ? GlCapture::outputSize(index, argument, args) : GlCapture::pointerNull;
+            GlCapture::write(&size, sizeof(size));
+            if (size == GlCapture::pointerOffset) GlCapture::write(&args[argument], sizeof(uint64_t));
+        }
+        else
+        {
+            GlCapture::write(&value, sizeof(value));
+        }
+    }
+
+    template <typename T>
+    static void writeOutput(const T value, const size_t argument, const std::span<const uint64_t> args)
+    {
+        if constexpr (std::is_pointer_v<T> && !std::is_const_v<std::remove_pointer_t<T>> && !isGlFunctionPointer<T> &&
+                      !std::is_same_v<T, GLsync>)
+        {
+            if (!value) return;
+            const uint64_t size = GlCapture::outputSize(index, argument, args);
+            if (size != GlCapture::pointerOffset) GlCapture::write(value, size);
+        }
+    }
+
+    static Result APIENTRY call(Args... args)
+    {
+        const uint64_t values[] = {toCaptureValue(args)..., 0};
+        const std::span<const uint64_t> raw(values, sizeof...(Args));
+        GlCapture::beginCall(index, raw);
+        size_t argument = 0;
+        (writeArgument(args, argument++, raw), ...);
+        if constexpr (std::is_void_v<Result>)
+        {
+            original(args...);
+            argument = 0;
+            (writeOutput(args, argument++, raw), ...);
+            GlCapture::endCall(index, raw, 0);
+        }
+        else
+        {
+            Result result = original(args...);
+            argument = 0;
+            (writeOutput(args, argument++, raw), ...);
+            if constexpr (!std::is_pointer_v<Result> || std::is_same_v<Result, GLsync>)
+            {
+                const uint64_t value = toCaptureValue(result);
+                GlCapture::write(&value, sizeof(value));
+            }
+            GlCapture::endCall(index, raw, toCaptureValue(result));
+            return result;
+        }
+    }
+
+    static void install(const char* name)
+    {
+        if (!*Slot || *Slot == &call) return;
+        original = *Slot;
+        index = GlCapture::registerFunction(name);
+        *Slot = &call;
+    }
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <type_traits>
+
+// Lazy loader mode: glad is handed resolver stubs instead of driver addresses, so loading only looks up the
+// functions its own version detection calls. Each stub asks the driver on its first call and then puts the
+// real address into the glad pointer. Enabled with --gl-lazy; GLVersion, the GLAD_GL_VERSION flags and the
+// set of pointers glad fills in come out the same as with gladLoadGLLoader.
+class GlLazyLoader
+{
+public:
+    // Replaces gladLoadGLLoader; the loader is kept for the stubs
+    static bool load(GLADloadproc loader);
+    // Throws runtime_error when the driver does not have the function
+    static void* resolve(const char* name);
+    // Driver lookups made so far
+    static size_t getResolved();
+};
+
+// One stub per entry point, keyed by the address of its glad pointer
+template <auto* Slot, typename Function = std::remove_pointer_t<decltype(Slot)>>
+struct GlLazyHook;
+
+template <auto* Slot, typename Result, typename... Args>
+struct GlLazyHook<Slot, Result (APIENTRYP)(Args...)>
+{
+    static inline const char* name = nullptr;
+    static inline Result (APIENTRYP resolved)(Args...) = nullptr;
+
+    static Result APIENTRY call(Args... args)
+    {
+        if (!resolved) resolved = reinterpret_cast<Result (APIENTRYP)(Args...)>(GlLazyLoader::resolve(name));
+        // A profiler or capture wrapper installed over the stub keeps its place and calls through here
+        if (*Slot == &call) *Slot = resolved;
+        return resolved(args...);
+    }
+
+    static void* stub(const char* function)
+    {
+        name = function;
+        return reinterpret_cast<void*>(&call);
+    }
+};
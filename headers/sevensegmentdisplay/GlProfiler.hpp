@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// Instrumented loader mode: every resolved glad entry point is swapped for a wrapper that counts calls and the
+// CPU time spent inside the driver, per frame. KHR_debug performance messages are attributed to the GL call
+// that raised them. Enabled at runtime with --gl-profile; without it the glad pointers are left untouched.
+class GlProfiler
+{
+public:
+    // GlHook index before the function is registered
+    static constexpr size_t unregistered = ~size_t(0);
+
+    // Wraps every non-null glad pointer; call once all entry points are resolved. "-" reports to stderr.
+    // Calling it again after glad loaded another context only re-wraps the reloaded pointers; the report and the
+    // per-function totals carry on.
+    static void install(const std::string& reportPath);
+    static bool isInstalled();
+    // Subscribes to performance messages; needs glDebugMessageCallback (GL 4.3 or KHR_debug)
+    static void enableDebugOutput();
+    // Writes the finished frame to the report and starts counting the next one
+    static void endFrame();
+    // Totals over every frame, most expensive first
+    static void printSummary(std::ostream& out);
+
+    static size_t registerFunction(const char* name);
+    static void record(size_t function, std::chrono::steady_clock::duration elapsed);
+    // Index of the call in progress, for attributing debug messages
+    static size_t current;
+};
+
+// One wrapper per entry point, keyed by the address of its glad pointer
+template <auto* Slot, typename Function = std::remove_pointer_t<decltype(Slot)>>
+struct GlHook;
+
+template <auto* Slot, typename Result, typename... Args>
+struct GlHook<Slot, Result (APIENTRYP)(Args...)>
+{
+    static inline Result (APIENTRYP original)(Args...) = nullptr;
+    static inline size_t index = GlProfiler::unregistered;
+
+    static Result APIENTRY call(Args... args)
+    {
+        GlProfiler::current = index;
+        const auto start = std::chrono::steady_clock::now();
+        if constexpr (std::is_void_v<Result>)
+        {
+            original(args...);
+            GlProfiler::record(index, std::chrono::steady_clock::now() - start);
+        }
+        else
+        {
+            Result result = original(args...);
+            GlProfiler::record(index, std::chrono::steady_clock::now() - start);
+            return result;
+        }
+    }
+
+    static void install(const char* name)
+    {
+        if (!*Slot || *Slot == &call) return;
+        original = *Slot;
+        if (index == GlProfiler::unregistered) index = GlProfiler::registerFunction(name);
+        *Slot = &call;
+    }
+};
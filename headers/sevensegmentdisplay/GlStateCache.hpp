@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Shadow copy of the GL state the renderer changes every frame: bound program, vertex array, array buffer,
+// viewport and the uniform values of each program. A call that would not change the state returns without
+// reaching the driver. Everything else that touches these bindings has to go through the cache as well.
+class GlStateCache
+{
+public:
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void bindArrayBuffer(GLuint buffer);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    // Uniforms of the program in use; location -1 is ignored like GL does
+    void uniform1i(GLint location, GLint value);
+    void uniform1f(GLint location, GLfloat value);
+    void uniform2f(GLint location, GLfloat x, GLfloat y);
+    void uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    void uniformMatrix4fv(GLint location, const GLfloat* value);
+    // Call before glDeleteProgram/glDeleteVertexArrays, the name may be handed out again
+    void forgetProgram(GLuint program);
+    void forgetVertexArray(GLuint vao);
+
+    // Calls passed on to the driver and calls dropped as redundant
+    [[nodiscard]] uint64_t getIssued() const;
+    [[nodiscard]] uint64_t getElided() const;
+
+private:
+    // Raw bits, so -0.0 vs 0.0 and NaN payloads count as changes like they would in GL
+    struct UniformValue
+    {
+        std::array<uint32_t, 16> bits{};
+        uint8_t size = 0;
+    };
+
+    // Stores the value and returns true when it differs from the cached one
+    bool updateUniform(GLint location, const void* value, uint8_t size);
+
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint arrayBuffer = 0;
+    // Unknown until the first glViewport; the default viewport depends on the window
+    std::array<GLint, 4> viewportBox{-1, -1, -1, -1};
+    std::unordered_map<GLuint, std::vector<UniformValue>> uniforms;
+    uint64_t issued = 0;
+    uint64_t elided = 0;
+};
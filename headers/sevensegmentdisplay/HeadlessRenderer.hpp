@@ -0,0 +1,24 @@
+#pragma once
+
+#include "sevensegmentdisplay/RenderBackend.hpp"
+
+// Draws nothing; measures the cost of everything around the renderer
+class HeadlessRenderer final : public RenderBackend
+{
+public:
+    explicit HeadlessRenderer(const RenderSettings& settings);
+
+    void drawFrame(const Scene& scene) override;
+    void present() override;
+    void pollEvents() override;
+    void resize(int width, int height) override;
+    [[nodiscard]] bool isOpen() const override;
+    [[nodiscard]] vec2 getScreenSize() const override;
+    [[nodiscard]] const char* getName() const override;
+    [[nodiscard]] const char* getReducedWorkload() const override;
+    [[nodiscard]] uint64_t getChecksum() const;
+
+private:
+    vec2 screenSize;
+    uint64_t checksum = 0;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct InputEvent
+{
+    uint64_t timestamp; // steady clock, nanoseconds
+    uint8_t value;
+};
+
+class InputQueue
+{
+public:
+    static constexpr size_t capacity = 256;
+    static constexpr size_t historyCapacity = 1024;
+
+    static void push(uint8_t value);
+    static bool drain();
+    static uint8_t getPending();
+    static void setHistoryEnabled(bool enabled);
+    static size_t getHistorySize();
+    static const InputEvent& getHistory(size_t index);
+    static uint64_t getReceived();
+    static uint64_t getCoalesced();
+    static uint64_t now();
+
+private:
+    static std::array<InputEvent, capacity> events;
+    static size_t count;
+    static std::array<InputEvent, historyCapacity> history;
+    static size_t historyHead;
+    static size_t historySize;
+    static bool historyEnabled;
+    static uint64_t received;
+    static uint64_t coalesced;
+};
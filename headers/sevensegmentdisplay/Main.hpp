@@ -12,8 +12,15 @@ public:
     static uint8_t getBits();
     static float getFrame();
     static float* getFramePtr();
+    static void setSegmentOverride(uint8_t mask, uint8_t value);
+    static uint8_t applySegmentOverride(uint8_t segments);
+    static void setBrightness(float newBrightness);
+    static float getBrightness();
 
 private:
     static uint8_t bits;
     static float frameNum;
+    static uint8_t overrideMask;
+    static uint8_t overrideValue;
+    static float brightness;
 };
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct Options
+{
+    bool history = false;
+    std::string feed;
+    std::string shm;
+    std::string vcd;
+    std::string vcdSignal;
+    double vcdSpeed = 1e-6;
+    uint64_t vcdSeek = 0;
+    std::string decode;
+    std::string decodeFormat = "rle";
+    std::string decodeOutput;
+    unsigned threads = 0;
+    std::string record;
+    std::string replay;
+    bool replayFast = false;
+    std::string exportPath;
+    std::string exportFormat;
+    int exportFps = 60;
+    int terminalFps = 60;
+    std::string backend = "gl33";
+    uint64_t frames = 0;
+    uint64_t bench = 0;
+    std::string bloom = "off";
+    std::string noise = "sin";
+    uint64_t noiseReport = 0;
+    bool temporal = false;
+    int flipbook = 0;
+    bool bakeFlipbook = false;
+    std::string profile = "custom";
+    std::string glProfile;
+    std::string glCapture;
+    bool glLazy = false;
+
+    static Options parse(int argc, char** argv);
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "sevensegmentdisplay/Scene.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class BloomQuality
+{
+    Off,
+    // Glow chain at 1/4 and 1/8 resolution
+    Low,
+    // 1/2 down to 1/8
+    Medium,
+    // 1/2 down to 1/16
+    High
+};
+
+enum class NoiseKernel
+{
+    // The original nested-sin hash; output depends on the driver's sin precision
+    Sine,
+    // PCG integer hash, identical everywhere
+    IntegerHash
+};
+
+enum class QualityProfile
+{
+    // The individual settings are used as given
+    Custom,
+    // Probe the GPU on the first start and cache the pick per machine (GL backends)
+    Auto,
+    Minimal,
+    Low,
+    Medium,
+    High
+};
+
+struct RenderSettings
+{
+    int width = 500;
+    int height = 700;
+    const char* title = "Sieben-Segment-Display";
+    bool visible = true;
+    bool vsync = true;
+    int terminalFps = 60;
+    BloomQuality bloom = BloomQuality::Off;
+    NoiseKernel noise = NoiseKernel::Sine;
+    // Shade the background in half the pixels per frame and take the rest from the previous frame (GL backends)
+    bool temporal = false;
+    // Layers of the baked background loop, 0 renders the background live (GL backends)
+    int flipbookLayers = 0;
+    // Upper bound for the fbm octaves; detail finer than a pixel is dropped either way
+    int maxOctaves = 14;
+    // Anything but Custom overrides noise, maxOctaves, temporal and bloom
+    QualityProfile profile = QualityProfile::Custom;
+    // Report file for the per-frame GL call profile, "-" for stderr; empty leaves the GL entry points unwrapped
+    std::string glProfile;
+    // Command stream file for ssd_gl_replay; empty records nothing
+    std::string glCapture;
+    // Resolve GL entry points on their first call instead of all of them while loading
+    bool lazyGl = false;
+};
+
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() = default;
+
+    virtual void drawFrame(const Scene& scene) = 0;
+    virtual void present() = 0;
+    virtual void pollEvents() = 0;
+    virtual void resize(int width, int height) = 0;
+    [[nodiscard]] virtual bool isOpen() const = 0;
+    [[nodiscard]] virtual vec2 getScreenSize() const = 0;
+    [[nodiscard]] virtual const char* getName() const = 0;
+    [[nodiscard]] virtual bool hasGlContext() const { return false; }
+    // What a frame leaves out compared to the GL renderer, for benchmark output; nullptr for nothing
+    [[nodiscard]] virtual const char* getReducedWorkload() const { return nullptr; }
+    // False when the backend builds segment shapes itself and only needs the scene's colors
+    [[nodiscard]] virtual bool needsGeometry() const { return true; }
+
+    // Names: gl33, gl45, gles30, procedural, software, headless, terminal
+    static std::unique_ptr<RenderBackend> create(const std::string& name, const RenderSettings& settings);
+    static const std::vector<std::string>& getNames();
+    static BloomQuality bloomFromName(const std::string& name);
+    static NoiseKernel noiseFromName(const std::string& name);
+    static QualityProfile profileFromName(const std::string& name);
+    static const char* getProfileName(QualityProfile profile);
+    static void applyProfile(QualityProfile profile, RenderSettings& settings);
+    // $XDG_CACHE_HOME/sevensegmentdisplay, falling back to ~/.cache
+    static std::string getCacheDirectory();
+};
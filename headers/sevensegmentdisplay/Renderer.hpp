@@ -1,5 +1,7 @@
 #pragma once
 
+#include "sevensegmentdisplay/GlStateCache.hpp"
+#include "sevensegmentdisplay/RenderBackend.hpp"
 #include "sevensegmentdisplay/Types.hpp"
 
 #include <iostream>
@@ -13,22 +15,166 @@
 using namespace glm;
 using std::vector, std::array, std::span;
 
-class Renderer
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+// Needs a current context; looks through the GL_EXTENSIONS list
+bool hasGlExtension(std::string_view name);
+
+class Renderer final : public RenderBackend
 {
 public:
-    Renderer(const int& width, const int& height, const char* title);
-    ~Renderer();
-    void drawFrame(const array<Segment, 7>& segments, const vector<vector<vec2>>& bitSquares) const;
+    enum class GlVersion
+    {
+        Gl33,
+        // Direct state access and a persistently mapped element ring; falls back to Gl33 when unavailable
+        Gl45,
+        // OpenGL ES 3.0 context with "#version 300 es" shaders, for GLES-only drivers
+        Gles30
+    };
+
+    enum class Geometry
+    {
+        // Scene shapes are uploaded into one indexed vertex buffer
+        Batched,
+        // The vertex shader builds the shapes from gl_VertexID/gl_InstanceID and layout uniforms, no vertex buffer
+        Procedural
+    };
+
+    explicit Renderer(const RenderSettings& settings, GlVersion version = GlVersion::Gl33, Geometry geometry = Geometry::Batched);
+    ~Renderer() override;
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    void drawFrame(const Scene& scene) override;
+    void present() override;
+    void pollEvents() override;
+    void resize(int width, int height) override;
+    [[nodiscard]] bool isOpen() const override;
+    [[nodiscard]] vec2 getScreenSize() const override;
+    [[nodiscard]] const char* getName() const override;
+    [[nodiscard]] bool hasGlContext() const override;
+    [[nodiscard]] bool needsGeometry() const override;
     [[nodiscard]] GLFWwindow* getWindow() const;
-    [[nodiscard]] static vec2 getScreenSize();
-    static void setScreenSize(vec2 newScreenSize);
+    // RGBA rows of the current frame, bottom row first
+    [[nodiscard]] vector<uint8_t> readPixels() const;
+    // Average GPU time of the bloom stage, 0 when it is off or not measured yet
+    [[nodiscard]] double getBloomMs() const;
+    [[nodiscard]] const GlStateCache& getStateCache() const;
 
 private:
+    static constexpr int ringSections = 3;
+    // Background, 7 segments and 4 indicators; the uniform block is sized for maxElements
+    static constexpr size_t elementCount = 12;
+    static constexpr size_t maxElements = 16;
+    // Transition lengths in frames, the unit of the time uniform
+    static constexpr float fadeInFrames = 4.0f;
+    static constexpr float afterglowFrames = 18.0f;
+
+    // Mirrors the std140 Element struct: color.w is the frame of the last change, previous.w the fade length
+    struct ElementState
+    {
+        vec4 color;
+        vec4 previous;
+    };
+
+    // 8 bytes: position normalized to the screen, the UV is derived from it in the shader
+    struct BatchVertex
+    {
+        uint16_t x, y;
+        uint8_t element;
+        uint8_t padding[3];
+    };
+
+    void addFan(span<const vec2> points, uint8_t element);
+    void buildGeometry(const Scene& scene);
+    void setLayoutUniforms();
+    bool updateElements(const Scene& scene);
+    void drawElements() const;
+    // Both return false when a framebuffer is incomplete; the targets are deleted again then
+    bool createBloomTargets();
+    void deleteBloomTargets();
+    void drawBloom();
+    bool createTemporalTargets();
+    void deleteTemporalTargets();
+    void drawCheckerboard(const Scene& scene);
+    void resolveTemporal();
+    QualityProfile probeProfile(const std::string& vertexSrc, const std::string& fragmentSrc);
+    // Background cost in ms per megapixel, from one short timed run of the probe shader
+    double measureBackground(const std::string& vertexSrc, const std::string& fragmentSrc, bool timerQuery);
+    void loadFlipbook(const std::string& vertexSrc, const std::string& fragmentSrc);
+    void bakeFlipbook(const std::string& vertexSrc, const std::string& fragmentSrc, int width, int height, const std::string& path,
+                      uint64_t shaderHash);
+
+    GlVersion version;
+    Geometry geometry;
     GLFWwindow* window;
+    // Every program, vertex array, array buffer, viewport and uniform change goes through here
+    GlStateCache glState;
     mat4 projection{};
-    static vec2 screenSize;
+    vec2 screenSize = vec2(0);
     GLuint shaderProgram{};
     GLuint vao{};
     GLuint vbo{};
-};
+    GLuint ebo{};
+    GLuint ubo{};
+    GLint projectionLoc = -1;
+    GLint timeLoc = -1;
+    GLint resolutionLoc = -1;
+    GLint brightnessLoc = -1;
+    GLint centerLoc = -1;
+    GLint segmentLengthLoc = -1;
+    GLint thicknessLoc = -1;
+    GLint taperLoc = -1;
+    GLint indicatorLayoutLoc = -1;
+    GLint glowPassLoc = -1;
+    vector<BatchVertex> batchVertices;
+    vector<uint16_t> batchIndices;
+    GLsizei indexCount = 0;
+    vec2 geometrySize = vec2(0);
+    // Per-element state, mirrored by the Elements uniform block and only uploaded when a color changes
+    array<ElementState, maxElements> elements{};
+    bool elementsValid = false;
+    uint8_t* ringData = nullptr;
+    size_t ringSectionSize = 0;
+    array<GLsync, ringSections> ringFences{};
+    int ringSection = 0;
 
+    BloomQuality bloom;
+    GLuint bloomProgram{};
+    GLint bloomModeLoc = -1;
+    GLint bloomHalfPixelLoc = -1;
+    GLint bloomIntensityLoc = -1;
+    // Level 0 is the largest; each further level halves the size
+    vector<GLuint> bloomTextures;
+    vector<GLuint> bloomFramebuffers;
+    vector<ivec2> bloomSizes;
+    // Timer queries are read ringSections frames later so the result never stalls the pipeline
+    array<GLuint, ringSections> bloomQueries{};
+    uint64_t bloomQueriesIssued = 0;
+    uint64_t bloomNanoseconds = 0;
+    uint64_t bloomSamples = 0;
+
+    bool temporal;
+    GLuint checkerProgram{};
+    GLint checkerTimeLoc = -1;
+    GLint checkerResolutionLoc = -1;
+    GLint checkerPhaseLoc = -1;
+    GLint elementCheckerPhaseLoc = -1;
+    GLint historyValidLoc = -1;
+    // Half-width pattern values for this frame's checkerboard half
+    GLuint checkerTexture{};
+    GLuint checkerFramebuffer{};
+    // The frame is drawn into sceneTexture and blitted to the window; historyFramebuffers[i] also write historyTextures[i]
+    GLuint sceneTexture{};
+    array<GLuint, 2> historyTextures{};
+    array<GLuint, 2> historyFramebuffers{};
+    int historyIndex = 0;
+    int checkerPhase = 0;
+    // False until a full frame has been drawn at the current size
+    bool historyValid = false;
+
+    // Baked background loop, see Flipbook; 0 layers shades pattern() live
+    int flipbookLayers;
+    GLuint flipbookTexture{};
+    GLint flipbookValidLoc = -1;
+    float flipbookAspect = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "sevensegmentdisplay/Types.hpp"
+
+#include <array>
+
+using std::array;
+
+// Everything a backend needs to draw one frame
+struct Scene
+{
+    uint8_t digit = 0;
+    array<Segment, 7> segments;
+    array<Segment, 4> indicators;
+    vec2 screenSize = vec2(0);
+    float time = 0;
+    float brightness = 1.0f;
+};
+
+// Placement of the digit and the bit indicators for a given screen size, in pixels
+struct GlyphLayout
+{
+    vec2 center = vec2(0);
+    float segmentLength = 0;
+    float thickness = 0;
+    float taper = 0;
+    float indicatorSize = 0;
+    float indicatorGap = 0;
+    // Center of the leftmost indicator
+    vec2 indicatorOrigin = vec2(0);
+};
+
+vector<vec2> createSegment(float cx, float cy, float length, float thickness, float taper);
+vector<vec2> rotate90CCW(const vector<vec2>& points, float cx, float cy);
+vector<vec2> createSquare(float cx, float cy, float size);
+GlyphLayout calculateLayout(vec2 screenSize);
+array<Segment, 7> calculateSegments(vec2 screenSize, uint8_t segmentValue);
+vector<vector<vec2>> calculateBitIndicators(vec2 screenSize);
+// Without geometry only the colors are filled in, for backends that generate the shapes themselves
+Scene buildScene(vec2 screenSize, bool geometry = true);
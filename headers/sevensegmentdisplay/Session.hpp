@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class RenderBackend;
+
+// Records key presses, resizes and frame boundaries into a compact file:
+// each event is a type byte, a varint microsecond delta to the previous event and varint arguments.
+class Session
+{
+public:
+    enum class EventType : uint8_t
+    {
+        Key = 0,
+        Resize = 1,
+        Frame = 2
+    };
+
+    static void startRecording(const std::string& path, int width, int height);
+    static void stopRecording();
+    static bool isRecording();
+    static void recordKey(int key, int scancode, int action, int mods);
+    static void recordResize(int width, int height);
+    static void recordFrame();
+
+private:
+    static void beginEvent(EventType type);
+    static void writeVarint(uint64_t value);
+    static void flush();
+
+    static std::vector<uint8_t> buffer;
+    static int fd;
+    static uint64_t lastTimestamp;
+};
+
+class SessionReplay
+{
+public:
+    explicit SessionReplay(const std::string& path);
+
+    bool dispatchFrame(RenderBackend& backend, bool realtime);
+    [[nodiscard]] int getWidth() const;
+    [[nodiscard]] int getHeight() const;
+    [[nodiscard]] uint64_t getFrames() const;
+    [[nodiscard]] bool isFinished() const;
+
+private:
+    uint64_t readVarint();
+
+    std::vector<uint8_t> data;
+    size_t offset = 0;
+    int width = 0;
+    int height = 0;
+    uint64_t frames = 0;
+    uint64_t recordedTime = 0;
+    uint64_t startTime = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "sevensegmentdisplay/RenderBackend.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Rasterizes the scene on the CPU into an RGBA buffer with flat material colors
+class SoftwareRenderer final : public RenderBackend
+{
+public:
+    static constexpr uint32_t backgroundColor = 0x0D0D0D;
+    static constexpr uint32_t onColor = 0xC00000;
+    static constexpr uint32_t offColor = 0x3C3C3C;
+
+    explicit SoftwareRenderer(const RenderSettings& settings);
+
+    void drawFrame(const Scene& scene) override;
+    void present() override;
+    void pollEvents() override;
+    void resize(int width, int height) override;
+    [[nodiscard]] bool isOpen() const override;
+    [[nodiscard]] vec2 getScreenSize() const override;
+    [[nodiscard]] const char* getName() const override;
+    [[nodiscard]] const char* getReducedWorkload() const override;
+    [[nodiscard]] const std::vector<uint32_t>& getPixels() const;
+
+    // Fills pixels (width x height, 0xRRGGBB) sampling the scene every `scale` scene units
+    static void rasterize(const Scene& scene, std::vector<uint32_t>& pixels, int width, int height, float scale);
+
+private:
+    int width;
+    int height;
+    std::vector<uint32_t> pixels;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "sevensegmentdisplay/RenderBackend.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <termios.h>
+
+// Draws the display into a terminal with half-block characters and 24-bit ANSI colors.
+// Each cell is two vertically stacked pixels; only cells that changed since the last frame are written.
+class TerminalRenderer final : public RenderBackend
+{
+public:
+    // Virtual pixels per terminal pixel, so the layout matches a window of similar physical size
+    static constexpr float pixelScale = 8.0f;
+
+    explicit TerminalRenderer(const RenderSettings& settings);
+    ~TerminalRenderer() override;
+    TerminalRenderer(const TerminalRenderer&) = delete;
+    TerminalRenderer& operator=(const TerminalRenderer&) = delete;
+
+    void drawFrame(const Scene& scene) override;
+    void present() override;
+    void pollEvents() override;
+    void resize(int width, int height) override;
+    [[nodiscard]] bool isOpen() const override;
+    [[nodiscard]] vec2 getScreenSize() const override;
+    [[nodiscard]] const char* getName() const override;
+    [[nodiscard]] const char* getReducedWorkload() const override;
+    [[nodiscard]] uint64_t getBytesWritten() const;
+
+private:
+    void querySize();
+    // False when the terminal stopped taking output part way through
+    bool flush();
+
+    int columns = 80;
+    int rows = 24;
+    bool open = true;
+    bool rawMode = false;
+    termios savedTermios{};
+    std::vector<uint32_t> pixels;
+    std::vector<uint64_t> cells;
+    std::vector<uint64_t> previousCells;
+    std::string output;
+    uint64_t bytesWritten = 0;
+    std::chrono::microseconds frameInterval;
+    std::chrono::steady_clock::time_point nextFrame;
+};
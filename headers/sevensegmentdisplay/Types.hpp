@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -8,6 +9,25 @@ using std::vector;
 using glm::vec2;
 using glm::vec3;
 
+inline constexpr uint8_t digitToSegments[16] = {
+    0b0111111, // 0
+    0b0000110, // 1
+    0b1011011, // 2
+    0b1001111, // 3
+    0b1100110, // 4
+    0b1101101, // 5
+    0b1111101, // 6
+    0b0000111, // 7
+    0b1111111, // 8
+    0b1101111, // 9
+    0b1110111, // A
+    0b1111100, // b
+    0b0111001, // C
+    0b1011110, // d
+    0b1111001, // E
+    0b1110001  // F
+};
+
 struct Segment {
     vector<vec2> points;
     vec3 color = vec3(1.0f, 1.0f, 1.0f);
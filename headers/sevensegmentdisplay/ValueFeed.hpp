@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Reads display values from another process. Sources: "stdin", "fifo:<path>", "unix:<path>".
+// Binary frames are 0xA5 followed by the value byte; anything else is read as hex text, one value per line.
+class ValueFeed
+{
+public:
+    static constexpr uint8_t frameMarker = 0xA5;
+    static constexpr size_t maxConnections = 16;
+
+    explicit ValueFeed(const std::string& source);
+    ~ValueFeed();
+    ValueFeed(const ValueFeed&) = delete;
+    ValueFeed& operator=(const ValueFeed&) = delete;
+
+    bool poll(uint8_t& value);
+    [[nodiscard]] uint64_t getMessages() const;
+
+private:
+    struct Parser
+    {
+        int fd = -1;
+        bool expectBinary = false;
+        bool inText = false;
+        uint8_t textValue = 0;
+    };
+
+    void run();
+    // False when every slot is taken or epoll refuses the fd; the caller still owns it then
+    bool addFd(int fd);
+    // Adds a source fd, falling back to plain reads for files epoll cannot watch; false on the fallback
+    bool watchSource(int fd, const std::string& name);
+    void closeConnection(Parser& parser);
+    bool drainFd(Parser& parser);
+    bool parse(Parser& parser, const uint8_t* data, size_t size, uint8_t& value);
+
+    int epollFd = -1;
+    int stopFd = -1;
+    int listenFd = -1;
+    bool ownsSocketPath = false;
+    // Original stdin flags, restored once the feed stops
+    int stdinFlags = -1;
+    Parser* unpolled = nullptr;
+    std::string socketPath;
+    std::array<Parser, maxConnections> connections{};
+    std::array<uint8_t, 64 * 1024> buffer{};
+    std::atomic<uint32_t> latest{0};
+    std::atomic<uint64_t> messages{0};
+    std::atomic<bool> stopping{false};
+    uint32_t lastSequence = 0;
+    std::thread thread;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Memory-mapped, incremental reader for one bus signal of a Value Change Dump.
+// A background thread builds a sparse index of parser checkpoints so seeks only rescan a short stretch.
+class VcdReader
+{
+public:
+    static constexpr size_t checkpointInterval = 1024 * 1024;
+
+    struct Cursor
+    {
+        size_t offset = 0;
+        uint64_t time = 0;
+        uint8_t value = 0;
+    };
+
+    struct Change
+    {
+        uint64_t time;
+        uint8_t value;
+    };
+
+    VcdReader(const std::string& path, const std::string& signal, bool indexed = true);
+    ~VcdReader();
+    VcdReader(const VcdReader&) = delete;
+    VcdReader& operator=(const VcdReader&) = delete;
+
+    void seek(uint64_t time);
+    bool advanceTo(uint64_t time);
+    [[nodiscard]] uint8_t getValue() const;
+    [[nodiscard]] uint64_t getTime() const;
+    [[nodiscard]] bool isFinished() const;
+    [[nodiscard]] double getTimescale() const;
+    [[nodiscard]] int getWidth() const;
+
+    [[nodiscard]] size_t getBodyOffset() const;
+    [[nodiscard]] size_t getSize() const;
+    [[nodiscard]] size_t findTimeBoundary(size_t offset) const;
+    // Returns the last timestamp in the range, which may come after the last change
+    uint64_t collectChanges(size_t begin, size_t end, std::vector<Change>& changes) const;
+
+private:
+    void parseHeader(const std::string& signal);
+    void scan(Cursor& cursor, uint64_t targetTime, size_t offsetLimit, std::vector<Change>* changes = nullptr) const;
+    void buildIndex();
+
+    int fd = -1;
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t bodyOffset = 0;
+    std::string identifier;
+    int width = 0;
+    double timescale = 1e-9;
+
+    Cursor cursor;
+    std::vector<Cursor> checkpoints;
+    mutable std::mutex indexMutex;
+    std::condition_variable checkpointAdded;
+    bool indexComplete = false;
+    std::atomic<bool> stopIndexing{false};
+    std::thread indexer;
+};
@@ -0,0 +1,63 @@
+#ifndef SSD_SHM_H
+#define SSD_SHM_H
+
+/*
+    Shared-memory display state for co-located producers.
+
+    The display process creates the segment, producers map it and write into it directly.
+    A sequence counter works as a seqlock: it is odd while a write is in progress, so
+    only one producer may write at a time.
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SSD_SHM_MAGIC 0x31445353u /* "SSD1" */
+#define SSD_SHM_VERSION 1u
+#define SSD_SHM_MAX_DIGITS 64
+#define SSD_SHM_DEFAULT_NAME "/sevensegmentdisplay"
+#define SSD_SHM_READ_ATTEMPTS 64
+
+typedef struct ssd_display_state {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sequence;
+    uint32_t digit_count;
+    float brightness; /* 0 to 1 */
+    uint8_t digits[SSD_SHM_MAX_DIGITS];
+    uint8_t segment_mask[SSD_SHM_MAX_DIGITS];  /* set bits replace the decoded segment */
+    uint8_t segment_value[SSD_SHM_MAX_DIGITS]; /* segment state used where the mask is set */
+} ssd_display_state;
+
+typedef struct ssd_shm {
+    int fd;
+    int owner;
+    char name[64];
+    ssd_display_state* state;
+} ssd_shm;
+
+/* create != 0 creates (and initialises) the segment, otherwise an existing one is mapped. Returns 0 on success. */
+int ssd_shm_open(ssd_shm* shm, const char* name, int create);
+void ssd_shm_close(ssd_shm* shm);
+
+void ssd_shm_begin_write(ssd_shm* shm);
+void ssd_shm_end_write(ssd_shm* shm);
+
+/* Convenience writers, each one a complete seqlock write */
+void ssd_shm_set_digit(ssd_shm* shm, uint32_t index, uint8_t value);
+void ssd_shm_set_segments(ssd_shm* shm, uint32_t index, uint8_t mask, uint8_t value);
+void ssd_shm_set_brightness(ssd_shm* shm, float brightness);
+
+/* Copies a consistent snapshot into out when the sequence moved past *last_sequence. Returns 1 if out was updated.
+   Gives up after SSD_SHM_READ_ATTEMPTS while a write is in progress, and skips snapshots with a brightness
+   outside 0 to 1 or too many digits; out keeps the previous snapshot in both cases. */
+int ssd_shm_read(const ssd_shm* shm, uint32_t* last_sequence, ssd_display_state* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SSD_SHM_H */
@@ -0,0 +1,260 @@
+#include "sevensegmentdisplay/BatchDecoder.hpp"
+#include "sevensegmentdisplay/Types.hpp"
+#include "sevensegmentdisplay/VcdReader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static void runParallel(const size_t chunkCount, const unsigned threadCount, const auto& work)
+{
+    vector<thread> workers;
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&, t]
+        {
+            for (size_t chunk = t; chunk < chunkCount; chunk += threadCount) work(chunk);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+static void appendRun(vector<SegmentRun>& runs, const SegmentRun run)
+{
+    // A later change at the same time replaces the earlier one
+    if (!runs.empty() && runs.back().start == run.start) runs.pop_back();
+    if (runs.empty() || runs.back().segments != run.segments) runs.push_back(run);
+}
+
+BatchDecoder::BatchDecoder(const string& input, const string& signal, const unsigned threads, const string& format, ostream& out)
+    : input(input), signal(signal), threads(max(1u, threads)), vcdInput(input.ends_with(".vcd")), vcdOutput(format == "vcd"),
+      out(out)
+{
+}
+
+void BatchDecoder::run()
+{
+    const auto start = chrono::steady_clock::now();
+    if (vcdInput)
+    {
+        decodeVcd();
+    }
+    else
+    {
+        decodeRaw();
+    }
+    writeFooter();
+    out.flush();
+    if (!out)
+    {
+        throw runtime_error("Failed to write the decoded output");
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void BatchDecoder::decodeRaw()
+{
+    const int fd = open(input.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw runtime_error("Failed to open sample file " + input);
+    }
+    struct stat info{};
+    fstat(fd, &info);
+    bytes = samples = endTime = static_cast<uint64_t>(info.st_size);
+    timescale = 1.0;
+    writeHeader();
+    if (samples == 0)
+    {
+        close(fd);
+        return;
+    }
+    void* mapping = mmap(nullptr, samples, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        throw runtime_error("Failed to map sample file " + input);
+    }
+    madvise(mapping, samples, MADV_SEQUENTIAL);
+    const auto* data = static_cast<const uint8_t*>(mapping);
+
+    const size_t chunkCount = threads * chunksPerThread;
+    vector<vector<SegmentRun>> chunks(chunkCount);
+    for (size_t window = 0; window < samples; window += chunkCount * chunkBytes)
+    {
+        runParallel(chunkCount, threads, [&](const size_t chunk)
+        {
+            const size_t begin = min<size_t>(window + chunk * chunkBytes, samples);
+            const size_t end = min<size_t>(begin + chunkBytes, samples);
+            auto& runs = chunks[chunk];
+            uint8_t current = 0xFF;
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (const uint8_t segments = digitToSegments[data[i] & 0xF]; segments != current)
+                {
+                    runs.push_back({i, segments});
+                    current = segments;
+                }
+            }
+        });
+        emit(chunks);
+        // Pages already decoded are not needed again
+        madvise(const_cast<uint8_t*>(data) + (window & ~size_t(4095)), min<size_t>(chunkCount * chunkBytes, samples - window), MADV_DONTNEED);
+    }
+    munmap(mapping, samples);
+}
+
+void BatchDecoder::decodeVcd()
+{
+    const VcdReader reader(input, signal, false);
+    bytes = reader.getSize();
+    timescale = reader.getTimescale();
+    writeHeader();
+
+    // Chunks start on timestamp lines so each one parses without knowing what came before
+    const size_t chunkCount = threads * chunksPerThread;
+    vector<vector<SegmentRun>> chunks(chunkCount);
+    vector<uint64_t> changeCounts(chunkCount);
+    vector<uint64_t> chunkEnds(chunkCount);
+    vector<size_t> bounds(chunkCount + 1);
+    size_t offset = reader.getBodyOffset();
+    while (offset < bytes)
+    {
+        bounds[0] = offset;
+        for (size_t chunk = 1; chunk <= chunkCount; ++chunk)
+        {
+            bounds[chunk] = reader.findTimeBoundary(min(bytes, bounds[chunk - 1] + chunkBytes));
+        }
+
+        runParallel(chunkCount, threads, [&](const size_t chunk)
+        {
+            vector<VcdReader::Change> changes;
+            chunkEnds[chunk] = reader.collectChanges(bounds[chunk], bounds[chunk + 1], changes);
+            changeCounts[chunk] = changes.size();
+            for (const auto& [time, value] : changes)
+            {
+                appendRun(chunks[chunk], {time, digitToSegments[value & 0xF]});
+            }
+        });
+
+        for (const auto count : changeCounts) samples += count;
+        for (const auto end : chunkEnds) endTime = max(endTime, end);
+        emit(chunks);
+        offset = bounds[chunkCount];
+    }
+}
+
+void BatchDecoder::emit(vector<vector<SegmentRun>>& chunks)
+{
+    // Chunk boundaries never split a timestamp, so only equal neighbours need merging
+    for (auto& chunk : chunks)
+    {
+        for (const auto& run : chunk)
+        {
+            if (run.segments != last.segments)
+            {
+                writeRun(run);
+                last = run;
+                runCount++;
+            }
+        }
+        chunk.clear();
+    }
+    out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void BatchDecoder::writeHeader()
+{
+    if (!vcdOutput)
+    {
+        out.write("SSDRLE1\n", 8);
+        return;
+    }
+
+    // Samples keep the input's time base; raw files count one unit per sample
+    constexpr pair<const char*, double> units[] = {{"s", 1}, {"ms", 1e-3}, {"us", 1e-6}, {"ns", 1e-9}, {"ps", 1e-12}, {"fs", 1e-15}};
+    const auto* unit = &units[5];
+    for (const auto& candidate : units)
+    {
+        if (timescale >= candidate.second * 0.999)
+        {
+            unit = &candidate;
+            break;
+        }
+    }
+    out << "$timescale " << lround(timescale / unit->second) << " " << unit->first << " $end\n";
+    out << "$scope module display $end\n";
+    for (int i = 0; i < 7; ++i)
+    {
+        out << "$var wire 1 " << static_cast<char>('!' + i) << " " << static_cast<char>('a' + i) << " $end\n";
+    }
+    out << "$upscope $end\n$enddefinitions $end\n";
+}
+
+void BatchDecoder::writeRun(const SegmentRun& run)
+{
+    if (!vcdOutput)
+    {
+        // LEB128 varint of the time delta to the previous run, then the segment byte
+        uint64_t delta = run.start - (runCount == 0 ? 0 : last.start);
+        do
+        {
+            buffer += static_cast<char>((delta & 0x7F) | (delta > 0x7F ? 0x80 : 0));
+            delta >>= 7;
+        } while (delta != 0);
+        buffer += static_cast<char>(run.segments);
+        return;
+    }
+
+    buffer += '#';
+    buffer += to_string(run.start);
+    buffer += '\n';
+    for (int i = 0; i < 7; ++i)
+    {
+        if (runCount == 0 || ((run.segments ^ last.segments) >> i & 1))
+        {
+            buffer += (run.segments >> i) & 1 ? '1' : '0';
+            buffer += static_cast<char>('!' + i);
+            buffer += '\n';
+        }
+    }
+}
+
+void BatchDecoder::writeFooter()
+{
+    if (vcdOutput) out << "#" << endTime << "\n";
+}
+
+uint64_t BatchDecoder::getSamples() const
+{
+    return samples;
+}
+
+const char* BatchDecoder::getSampleUnit() const
+{
+    return vcdInput ? "changes" : "samples";
+}
+
+uint64_t BatchDecoder::getBytes() const
+{
+    return bytes;
+}
+
+uint64_t BatchDecoder::getRunCount() const
+{
+    return runCount;
+}
+
+double BatchDecoder::getSeconds() const
+{
+    return seconds;
+}
@@ -0,0 +1,174 @@
+#include "sevensegmentdisplay/Benchmark.hpp"
+#include "sevensegmentdisplay/Main.hpp"
+#include "sevensegmentdisplay/Renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+int Benchmark::run(const string& backend, const uint64_t frames, RenderSettings settings)
+{
+    vector<string> names;
+    if (backend == "all")
+    {
+        // The terminal backend takes over the tty, so it has to be asked for by name
+        for (const string& name : RenderBackend::getNames())
+        {
+            if (name != "terminal") names.push_back(name);
+        }
+    }
+    else
+    {
+        stringstream list(backend);
+        for (string name; getline(list, name, ',');) names.push_back(name);
+    }
+    if (!settings.glCapture.empty() && names.size() > 1)
+    {
+        // The capture header describes a single context, which is all the replay tool can recreate
+        cerr << "--gl-capture records one context; benchmark a single backend with it" << endl;
+        return -1;
+    }
+
+    settings.visible = false;
+    settings.vsync = false;
+    settings.terminalFps = 1000000;
+
+    int result = 0;
+    vector<string> lines;
+    for (const string& name : names)
+    {
+        unique_ptr<RenderBackend> renderer;
+        const auto createStart = chrono::steady_clock::now();
+        try
+        {
+            renderer = RenderBackend::create(name, settings);
+        }
+        catch (const exception& e)
+        {
+            cerr << name << ": " << e.what() << endl;
+            result = -1;
+            continue;
+        }
+
+        const double startupMs = chrono::duration<double, milli>(chrono::steady_clock::now() - createStart).count();
+
+        *Main::getFramePtr() = 0;
+        vector<float> frameTimes;
+        frameTimes.reserve(frames);
+        for (uint64_t frame = 0; frame < frames && renderer->isOpen(); ++frame)
+        {
+            Main::setBits(frame & 0xF);
+            const auto frameStart = chrono::steady_clock::now();
+            renderer->drawFrame(buildScene(renderer->getScreenSize(), renderer->needsGeometry()));
+            renderer->present();
+            renderer->pollEvents();
+            frameTimes.push_back(chrono::duration<float, milli>(chrono::steady_clock::now() - frameStart).count());
+            (*Main::getFramePtr())++;
+        }
+        const auto* gl = dynamic_cast<const Renderer*>(renderer.get());
+        const char* reducedWorkload = renderer->getReducedWorkload();
+        const double bloomMs = gl ? gl->getBloomMs() : 0;
+        const uint64_t stateIssued = gl ? gl->getStateCache().getIssued() : 0;
+        const uint64_t stateElided = gl ? gl->getStateCache().getElided() : 0;
+        renderer.reset();
+        if (frameTimes.empty()) continue;
+
+        vector<float> sorted = frameTimes;
+        sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (const float t : frameTimes) total += t;
+        auto percentile = [&](const double p) { return sorted[min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))]; };
+
+        stringstream line;
+        line << name << ": startup " << startupMs << " ms, " << frameTimes.size() << " frames, mean " << total / frameTimes.size() << " ms, p50 "
+             << percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms";
+        if (bloomMs > 0) line << ", bloom " << bloomMs << " ms GPU";
+        if (gl) line << ", " << stateElided << " of " << stateIssued + stateElided << " state calls elided";
+        // Not comparable with the GL numbers
+        if (reducedWorkload) line << " [" << reducedWorkload << "]";
+        lines.push_back(line.str());
+    }
+
+    // Printed after all backends ran, so a terminal backend cannot overwrite the results
+    for (const string& line : lines) cout << line << "\n";
+    return result;
+}
+
+int Benchmark::compareNoise(const string& backend, const uint64_t frames, RenderSettings settings)
+{
+    settings.visible = false;
+    settings.vsync = false;
+
+    constexpr array kernels = {NoiseKernel::Sine, NoiseKernel::IntegerHash};
+    constexpr array kernelNames = {"sin", "int"};
+    array<vector<uint8_t>, 2> images;
+    for (size_t k = 0; k < kernels.size(); ++k)
+    {
+        settings.noise = kernels[k];
+        unique_ptr<RenderBackend> renderer = RenderBackend::create(backend, settings);
+        const auto* gl = dynamic_cast<const Renderer*>(renderer.get());
+        if (!gl)
+        {
+            cerr << "The noise report needs an OpenGL backend" << endl;
+            return -1;
+        }
+
+        // Same digit and same time values for both kernels
+        *Main::getFramePtr() = 0;
+        Main::setBits(8);
+        double total = 0;
+        for (uint64_t frame = 0; frame < frames; ++frame)
+        {
+            const auto frameStart = chrono::steady_clock::now();
+            renderer->drawFrame(buildScene(renderer->getScreenSize(), renderer->needsGeometry()));
+            if (frame + 1 == frames) images[k] = gl->readPixels();
+            renderer->present();
+            renderer->pollEvents();
+            total += chrono::duration<double, milli>(chrono::steady_clock::now() - frameStart).count();
+            (*Main::getFramePtr())++;
+        }
+        cout << kernelNames[k] << ": " << frames << " frames, mean " << total / max<uint64_t>(1, frames) << " ms\n";
+    }
+    if (images[0].empty() || images[0].size() != images[1].size()) return -1;
+
+    // Pixel error says how far apart the two fields are, luma statistics and histograms whether they look alike
+    constexpr int bins = 64;
+    array<array<uint64_t, bins>, 2> histograms{};
+    array<double, 2> lumaSum{}, lumaSquares{};
+    double absoluteError = 0, squaredError = 0;
+    const size_t pixels = images[0].size() / 4;
+    for (size_t i = 0; i < pixels; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            const double difference = static_cast<double>(images[0][i * 4 + c]) - images[1][i * 4 + c];
+            absoluteError += abs(difference);
+            squaredError += difference * difference;
+        }
+        for (size_t k = 0; k < 2; ++k)
+        {
+            const uint8_t* p = &images[k][i * 4];
+            const double luma = 0.299 * p[0] + 0.587 * p[1] + 0.114 * p[2];
+            lumaSum[k] += luma;
+            lumaSquares[k] += luma * luma;
+            histograms[k][min(bins - 1, static_cast<int>(luma * bins / 256))]++;
+        }
+    }
+
+    uint64_t overlap = 0;
+    for (int b = 0; b < bins; ++b) overlap += min(histograms[0][b], histograms[1][b]);
+    const double mse = squaredError / (pixels * 3);
+    auto mean = [&](const size_t k) { return lumaSum[k] / pixels; };
+    auto deviation = [&](const size_t k) { return sqrt(max(0.0, lumaSquares[k] / pixels - mean(k) * mean(k))); };
+
+    cout << "int vs sin: PSNR " << (mse > 0 ? 10 * log10(255.0 * 255.0 / mse) : INFINITY) << " dB, MAE "
+         << absoluteError / (pixels * 3) << ", luma mean " << mean(0) << " / " << mean(1) << ", luma stddev "
+         << deviation(0) << " / " << deviation(1) << ", histogram overlap " << 100.0 * overlap / pixels << " %\n";
+    return 0;
+}
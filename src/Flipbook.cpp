@@ -0,0 +1,210 @@
+#include "sevensegmentdisplay/Flipbook.hpp"
+#include "sevensegmentdisplay/RenderBackend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static constexpr char flipbookMagic[8] = {'S', 'S', 'D', 'F', 'L', 'I', 'P', '1'};
+
+// The eight levels of a BC4 block with red0 > red1; indices 2-7 interpolate from red0 towards red1
+static array<uint8_t, 8> blockPalette(const uint8_t red0, const uint8_t red1)
+{
+    array<uint8_t, 8> palette{red0, red1};
+    for (int k = 2; k < 8; ++k) palette[k] = static_cast<uint8_t>(((8 - k) * red0 + (k - 1) * red1 + 3) / 7);
+    return palette;
+}
+
+Flipbook::Flipbook(const string& path, const int width, const int height, const int layers, const uint64_t shaderHash)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("No flipbook cache at " + path);
+    struct stat info{};
+    fstat(fd, &info);
+    mappingSize = static_cast<size_t>(info.st_size);
+    const size_t expected = sizeof(Header) + layerBytes(width, height) * layers;
+    if (mappingSize != expected)
+    {
+        close(fd);
+        throw runtime_error("Flipbook cache " + path + " has the wrong size");
+    }
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        mapping = nullptr;
+        throw runtime_error("Failed to map flipbook cache " + path);
+    }
+
+    const Header header = makeHeader(width, height, layers, shaderHash);
+    if (memcmp(mapping, &header, sizeof(header)) != 0)
+    {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        throw runtime_error("Flipbook cache " + path + " does not match the shader");
+    }
+    // The whole file is uploaded right away
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+}
+
+Flipbook::~Flipbook()
+{
+    if (mapping) munmap(mapping, mappingSize);
+}
+
+string Flipbook::cachePath(const int width, const int height, const int layers, const uint64_t shaderHash)
+{
+    char name[96];
+    snprintf(name, sizeof(name), "flipbook-%dx%d-%d-%016llx.bc4", width, height, layers, static_cast<unsigned long long>(shaderHash));
+    return (filesystem::path(RenderBackend::getCacheDirectory()) / name).string();
+}
+
+uint64_t Flipbook::hash(const string_view text)
+{
+    uint64_t value = 14695981039346656037ull;
+    for (const char c : text)
+    {
+        value ^= static_cast<uint8_t>(c);
+        value *= 1099511628211ull;
+    }
+    return value;
+}
+
+size_t Flipbook::layerBytes(const int width, const int height)
+{
+    return static_cast<size_t>(width / 4) * static_cast<size_t>(height / 4) * 8;
+}
+
+void Flipbook::compressLayer(const uint8_t* pixels, const int width, const int height, uint8_t* blocks)
+{
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4, blocks += 8)
+        {
+            uint8_t texels[16];
+            for (int i = 0; i < 16; ++i) texels[i] = pixels[static_cast<size_t>(by + i / 4) * width + bx + i % 4];
+            const auto [low, high] = minmax_element(begin(texels), end(texels));
+
+            blocks[0] = *high;
+            blocks[1] = *low;
+            uint64_t indices = 0;
+            if (*high != *low)
+            {
+                const array<uint8_t, 8> palette = blockPalette(*high, *low);
+                for (int i = 0; i < 16; ++i)
+                {
+                    uint64_t best = 0;
+                    for (uint64_t k = 1; k < 8; ++k)
+                    {
+                        if (abs(palette[k] - texels[i]) < abs(palette[best] - texels[i])) best = k;
+                    }
+                    indices |= best << (3 * i);
+                }
+            }
+            for (int i = 0; i < 6; ++i) blocks[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+        }
+    }
+}
+
+void Flipbook::decompressLayer(const uint8_t* blocks, const int width, const int height, uint8_t* pixels)
+{
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4, blocks += 8)
+        {
+            // Only the red0 > red1 mode is ever written; equal endpoints give a flat block
+            const array<uint8_t, 8> palette = blockPalette(blocks[0], blocks[1]);
+            uint64_t indices = 0;
+            for (int i = 0; i < 6; ++i) indices |= static_cast<uint64_t>(blocks[2 + i]) << (8 * i);
+            for (int i = 0; i < 16; ++i)
+            {
+                pixels[static_cast<size_t>(by + i / 4) * width + bx + i % 4] = palette[indices >> (3 * i) & 7];
+            }
+        }
+    }
+}
+
+double Flipbook::checkRoundTrip(const uint8_t* pixels, const uint8_t* blocks, const int width, const int height)
+{
+    vector<uint8_t> decoded(static_cast<size_t>(width) * height);
+    decompressLayer(blocks, width, height, decoded.data());
+    double squaredError = 0;
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            int low = 255, high = 0;
+            for (int i = 0; i < 16; ++i)
+            {
+                const int texel = pixels[static_cast<size_t>(by + i / 4) * width + bx + i % 4];
+                low = min(low, texel);
+                high = max(high, texel);
+            }
+            for (int i = 0; i < 16; ++i)
+            {
+                const size_t index = static_cast<size_t>(by + i / 4) * width + bx + i % 4;
+                const int error = abs(decoded[index] - pixels[index]);
+                // Half a palette step, plus one for the rounding of the interpolated levels
+                if (14 * error > high - low + 14)
+                {
+                    throw runtime_error("BC4 round trip off by " + to_string(error) + " at " + to_string(bx + i % 4) + "," +
+                                        to_string(by + i / 4));
+                }
+                squaredError += static_cast<double>(error) * error;
+            }
+        }
+    }
+    return squaredError;
+}
+
+int Flipbook::correlatedLayers()
+{
+    return static_cast<int>(ceil(period * maxDriftPerFrame / maxLayerDrift));
+}
+
+void Flipbook::write(const string& path, const int width, const int height, const int layers, const uint64_t shaderHash,
+                     const vector<uint8_t>& blocks)
+{
+    filesystem::create_directories(filesystem::path(path).parent_path());
+    const string temporary = path + ".tmp" + to_string(getpid());
+    {
+        ofstream out(temporary, ios::binary);
+        const Header header = makeHeader(width, height, layers, shaderHash);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(blocks.data()), static_cast<streamsize>(blocks.size()));
+        if (!out) throw runtime_error("Failed to write flipbook cache " + temporary);
+    }
+    filesystem::rename(temporary, path);
+}
+
+const uint8_t* Flipbook::getBlocks() const
+{
+    return static_cast<const uint8_t*>(mapping) + sizeof(Header);
+}
+
+size_t Flipbook::getSize() const
+{
+    return mappingSize - sizeof(Header);
+}
+
+Flipbook::Header Flipbook::makeHeader(const int width, const int height, const int layers, const uint64_t shaderHash)
+{
+    Header header{};
+    memcpy(header.magic, flipbookMagic, sizeof(header.magic));
+    header.width = width;
+    header.height = height;
+    header.layers = layers;
+    header.shaderHash = shaderHash;
+    return header;
+}
@@ -0,0 +1,428 @@
+#include "sevensegmentdisplay/FrameExporter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <zlib.h>
+
+using namespace std;
+
+static constexpr uint8_t pngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+static void putBigEndian(vector<uint8_t>& out, const uint32_t value)
+{
+    out.push_back(value >> 24);
+    out.push_back(value >> 16 & 0xFF);
+    out.push_back(value >> 8 & 0xFF);
+    out.push_back(value & 0xFF);
+}
+
+static vector<uint8_t> pngHeader(const int width, const int height)
+{
+    vector<uint8_t> ihdr;
+    putBigEndian(ihdr, width);
+    putBigEndian(ihdr, height);
+    ihdr.insert(ihdr.end(), {8, 6, 0, 0, 0}); // 8-bit RGBA, no interlace
+    return ihdr;
+}
+
+static vector<uint8_t> pngChunk(const char* type, const uint8_t* payload, const size_t size)
+{
+    vector<uint8_t> chunk;
+    chunk.reserve(size + 12);
+    putBigEndian(chunk, static_cast<uint32_t>(size));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), payload, payload + size);
+    putBigEndian(chunk, crc32(0, chunk.data() + 4, static_cast<uInt>(size + 4)));
+    return chunk;
+}
+
+FrameExporter::FrameExporter(const string& path, const Format format, const int width, const int height, const int fps, const unsigned workers)
+    : path(path), format(format), width(width), height(height), fps(fps)
+{
+    if (format == Format::Y4m)
+    {
+        // 4:2:0 chroma needs even dimensions
+        this->width &= ~1;
+        this->height &= ~1;
+    }
+
+    if (format == Format::Png)
+    {
+        if (error_code error; !filesystem::create_directories(path, error) && error)
+        {
+            throw runtime_error("Failed to create export directory " + path + ": " + error.message());
+        }
+    }
+    else
+    {
+        out.open(path, ios::binary);
+        if (!out)
+        {
+            throw runtime_error("Failed to create export file " + path);
+        }
+        writeHeader();
+    }
+
+    const auto bytes = static_cast<GLsizeiptr>(this->width) * this->height * 4;
+    for (auto& slot : slots)
+    {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    for (unsigned i = 0; i < max(1u, workers); ++i)
+    {
+        threads.emplace_back(&FrameExporter::work, this);
+    }
+}
+
+FrameExporter::~FrameExporter()
+{
+    finish();
+}
+
+FrameExporter::Format FrameExporter::formatFromName(const string& name)
+{
+    if (name == "y4m" || name.ends_with(".y4m")) return Format::Y4m;
+    if (name == "rgba" || name.ends_with(".rgba") || name.ends_with(".raw")) return Format::Rgba;
+    if (name == "apng" || name.ends_with(".apng")) return Format::Apng;
+    if (name == "png" || name.ends_with(".png")) return Format::Png;
+    throw invalid_argument("Unknown export format: " + name);
+}
+
+void FrameExporter::capture()
+{
+    const auto start = chrono::steady_clock::now();
+
+    // The slot about to be reused holds the oldest readback; it is three frames old and almost always done
+    Slot& slot = slots[frameIndex % ringSize];
+    if (slot.fence) collect(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.index = frameIndex++;
+
+    // Pick up any other readback that already finished without waiting
+    for (auto& other : slots)
+    {
+        if (other.fence && &other != &slot && glClientWaitSync(other.fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+        {
+            collect(other);
+        }
+    }
+
+    captureSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void FrameExporter::collect(Slot& slot)
+{
+    glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1e9));
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    vector<uint8_t> pixels;
+    {
+        lock_guard lock(mutex);
+        if (jobs.size() >= maxQueuedFrames)
+        {
+            dropped++;
+            // Ordered writers skip the missing frame
+            if (format != Format::Png) ready[slot.index] = {};
+            return;
+        }
+        if (!pool.empty())
+        {
+            pixels = std::move(pool.back());
+            pool.pop_back();
+        }
+    }
+
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    pixels.resize(rowBytes * height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (const auto* mapped = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(pixels.size()), GL_MAP_READ_BIT)))
+    {
+        // GL rows start at the bottom
+        for (int y = 0; y < height; ++y)
+        {
+            memcpy(pixels.data() + y * rowBytes, mapped + (height - 1 - y) * rowBytes, rowBytes);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    lock_guard lock(mutex);
+    jobs.push_back({slot.index, std::move(pixels)});
+    captured++;
+    available.notify_one();
+}
+
+void FrameExporter::finish()
+{
+    if (threads.empty()) return;
+
+    for (size_t i = 0; i < ringSize; ++i)
+    {
+        Slot& slot = slots[(frameIndex + i) % ringSize];
+        if (slot.fence) collect(slot);
+    }
+    {
+        lock_guard lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& thread : threads) thread.join();
+    threads.clear();
+
+    for (auto& slot : slots)
+    {
+        glDeleteBuffers(1, &slot.pbo);
+    }
+
+    // Failed frame writes are already counted; this catches the trailer and the final flush
+    const bool framesWritten = static_cast<bool>(out);
+    if (format == Format::Apng)
+    {
+        writeChunk("IEND", nullptr, 0);
+        // The frame count is only known now
+        vector<uint8_t> actl;
+        putBigEndian(actl, apngFrames);
+        putBigEndian(actl, 0);
+        out.seekp(actlPosition);
+        writeChunk("acTL", actl.data(), actl.size());
+    }
+    if (format != Format::Png)
+    {
+        out.close();
+        if (framesWritten && !out) failed++;
+    }
+}
+
+void FrameExporter::work()
+{
+    while (true)
+    {
+        Job job;
+        {
+            unique_lock lock(mutex);
+            available.wait(lock, [&] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        vector<uint8_t> encoded = encode(job.pixels);
+        if (format == Format::Png)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%06llu.png", static_cast<unsigned long long>(job.index));
+            ofstream file(path + "/" + name, ios::binary);
+            file.write(reinterpret_cast<const char*>(pngSignature), sizeof(pngSignature));
+            const auto ihdr = pngHeader(width, height);
+            const auto header = pngChunk("IHDR", ihdr.data(), ihdr.size());
+            const auto data = pngChunk("IDAT", encoded.data(), encoded.size());
+            const auto end = pngChunk("IEND", nullptr, 0);
+            file.write(reinterpret_cast<const char*>(header.data()), static_cast<streamsize>(header.size()));
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<streamsize>(data.size()));
+            file.write(reinterpret_cast<const char*>(end.data()), static_cast<streamsize>(end.size()));
+            file.close();
+            if (!file)
+            {
+                lock_guard lock(mutex);
+                failed++;
+            }
+        }
+        else
+        {
+            writeOrdered(job.index, std::move(encoded));
+        }
+
+        lock_guard lock(mutex);
+        pool.push_back(std::move(job.pixels));
+    }
+}
+
+vector<uint8_t> FrameExporter::encode(const vector<uint8_t>& pixels) const
+{
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    switch (format)
+    {
+    case Format::Rgba:
+        return pixels;
+    case Format::Y4m:
+    {
+        // BT.601 full range, chroma averaged over 2x2 blocks
+        const size_t lumaSize = static_cast<size_t>(width) * height;
+        vector<uint8_t> yuv(lumaSize + lumaSize / 2);
+        uint8_t* u = yuv.data() + lumaSize;
+        uint8_t* v = u + lumaSize / 4;
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const uint8_t* p = pixels.data() + y * rowBytes + x * 4;
+                yuv[y * width + x] = static_cast<uint8_t>((77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8);
+            }
+        }
+        for (int y = 0; y < height; y += 2)
+        {
+            for (int x = 0; x < width; x += 2)
+            {
+                int r = 0, g = 0, b = 0;
+                for (int dy = 0; dy < 2; ++dy)
+                {
+                    for (int dx = 0; dx < 2; ++dx)
+                    {
+                        const uint8_t* p = pixels.data() + (y + dy) * rowBytes + (x + dx) * 4;
+                        r += p[0];
+                        g += p[1];
+                        b += p[2];
+                    }
+                }
+                const size_t index = (y / 2) * (width / 2) + x / 2;
+                u[index] = static_cast<uint8_t>(clamp(128 + ((-43 * r - 85 * g + 128 * b) >> 10), 0, 255));
+                v[index] = static_cast<uint8_t>(clamp(128 + ((128 * r - 107 * g - 21 * b) >> 10), 0, 255));
+            }
+        }
+        return yuv;
+    }
+    case Format::Png:
+    case Format::Apng:
+    {
+        // Each row gets filter type 0, then the whole image is deflated at the fastest level
+        vector<uint8_t> filtered((rowBytes + 1) * height);
+        for (int y = 0; y < height; ++y)
+        {
+            filtered[y * (rowBytes + 1)] = 0;
+            memcpy(filtered.data() + y * (rowBytes + 1) + 1, pixels.data() + y * rowBytes, rowBytes);
+        }
+        uLongf size = compressBound(static_cast<uLong>(filtered.size()));
+        vector<uint8_t> compressed(size);
+        compress2(compressed.data(), &size, filtered.data(), static_cast<uLong>(filtered.size()), Z_BEST_SPEED);
+        compressed.resize(size);
+        return compressed;
+    }
+    }
+    return {};
+}
+
+void FrameExporter::writeOrdered(const uint64_t index, vector<uint8_t> encoded)
+{
+    {
+        lock_guard lock(mutex);
+        ready[index] = std::move(encoded);
+    }
+
+    // Taking the contiguous run under writeMutex keeps runs in order, while collect() on the render
+    // thread only ever waits for the map update, never for the disk
+    lock_guard writeLock(writeMutex);
+    vector<vector<uint8_t>> run;
+    {
+        lock_guard lock(mutex);
+        while (!ready.empty() && ready.begin()->first == nextToWrite)
+        {
+            run.push_back(std::move(ready.begin()->second));
+            ready.erase(ready.begin());
+            nextToWrite++;
+        }
+    }
+
+    uint64_t runFailed = 0;
+    for (const auto& frame : run)
+    {
+        if (frame.empty()) continue; // dropped
+
+        switch (format)
+        {
+        case Format::Y4m:
+            out.write("FRAME\n", 6);
+            out.write(reinterpret_cast<const char*>(frame.data()), static_cast<streamsize>(frame.size()));
+            break;
+        case Format::Rgba:
+            out.write(reinterpret_cast<const char*>(frame.data()), static_cast<streamsize>(frame.size()));
+            break;
+        case Format::Apng:
+        {
+            vector<uint8_t> fctl;
+            putBigEndian(fctl, apngSequence++);
+            putBigEndian(fctl, width);
+            putBigEndian(fctl, height);
+            putBigEndian(fctl, 0);
+            putBigEndian(fctl, 0);
+            fctl.insert(fctl.end(), {0, 1, static_cast<uint8_t>(fps >> 8), static_cast<uint8_t>(fps & 0xFF), 0, 0});
+            writeChunk("fcTL", fctl.data(), fctl.size());
+            if (apngFrames++ == 0)
+            {
+                writeChunk("IDAT", frame.data(), frame.size());
+            }
+            else
+            {
+                vector<uint8_t> fdat;
+                fdat.reserve(frame.size() + 4);
+                putBigEndian(fdat, apngSequence++);
+                fdat.insert(fdat.end(), frame.begin(), frame.end());
+                writeChunk("fdAT", fdat.data(), fdat.size());
+            }
+            break;
+        }
+        case Format::Png:
+            break;
+        }
+        if (!out) runFailed++;
+    }
+    if (runFailed)
+    {
+        lock_guard lock(mutex);
+        failed += runFailed;
+    }
+}
+
+void FrameExporter::writeHeader()
+{
+    if (format == Format::Y4m)
+    {
+        out << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C420jpeg\n";
+    }
+    else if (format == Format::Apng)
+    {
+        out.write(reinterpret_cast<const char*>(pngSignature), sizeof(pngSignature));
+        const auto ihdr = pngHeader(width, height);
+        writeChunk("IHDR", ihdr.data(), ihdr.size());
+        actlPosition = out.tellp();
+        const vector<uint8_t> actl(8, 0);
+        writeChunk("acTL", actl.data(), actl.size());
+    }
+}
+
+void FrameExporter::writeChunk(const char* type, const uint8_t* payload, const size_t size)
+{
+    const auto chunk = pngChunk(type, payload, size);
+    out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<streamsize>(chunk.size()));
+}
+
+uint64_t FrameExporter::getCaptured() const
+{
+    return captured;
+}
+
+uint64_t FrameExporter::getDropped() const
+{
+    return dropped;
+}
+
+uint64_t FrameExporter::getFailed() const
+{
+    return failed;
+}
+
+double FrameExporter::getAverageCaptureMs() const
+{
+    return frameIndex == 0 ? 0.0 : captureSeconds * 1000.0 / static_cast<double>(frameIndex);
+}
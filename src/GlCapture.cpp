@@ -0,0 +1,204 @@
+#include "sevensegmentdisplay/GlCapture.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+struct MappedRange
+{
+    const uint8_t* data;
+    uint64_t offset;
+    uint64_t size;
+};
+
+static vector<string_view> functions;
+static unique_ptr<ofstream> file;
+static bool installed = false;
+// Write mappings by buffer name; their contents are recorded when a range of them is bound and when they are unmapped
+static unordered_map<uint64_t, MappedRange> mappings;
+
+static void writeString(const string_view text)
+{
+    const auto length = static_cast<uint32_t>(text.size());
+    GlCapture::write(&length, sizeof(length));
+    GlCapture::write(text.data(), text.size());
+}
+
+static void writeMappedRange(const uint64_t buffer, const uint64_t offset, const uint64_t size)
+{
+    const auto mapping = mappings.find(buffer);
+    if (mapping == mappings.end()) return;
+    const MappedRange& range = mapping->second;
+    if (offset < range.offset || offset + size > range.offset + range.size)
+    {
+        throw runtime_error("GL capture: bound range is outside the mapped range");
+    }
+    GlCapture::write(&GlCapture::mappedWriteRecord, sizeof(GlCapture::mappedWriteRecord));
+    GlCapture::write(&buffer, sizeof(buffer));
+    GlCapture::write(&offset, sizeof(offset));
+    GlCapture::write(&size, sizeof(size));
+    GlCapture::write(range.data + (offset - range.offset), size);
+}
+
+// Client memory read by GL for an image; a bound unpack buffer turns the pointer into an offset
+static uint64_t imageSize(const uint64_t width, const uint64_t height, const uint64_t depth, const uint64_t format, const uint64_t type,
+                          const GLenum bufferBinding)
+{
+    GLint buffer = 0;
+    GlCaptureHook<&glad_glGetIntegerv>::original(bufferBinding, &buffer);
+    if (buffer) return GlCapture::pointerOffset;
+
+    const uint64_t components = format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_RGB ? 3 : format == GL_RGBA ? 4 : 0;
+    const uint64_t componentSize = type == GL_UNSIGNED_BYTE ? 1 : type == GL_HALF_FLOAT ? 2 : type == GL_FLOAT ? 4 : 0;
+    if (!components || !componentSize) throw runtime_error("GL capture: unsupported pixel format");
+    // Rows are padded to the default alignment of 4
+    const uint64_t row = (width * components * componentSize + 3) / 4 * 4;
+    return row * height * depth;
+}
+
+void GlCapture::install(const string& path, const string& context, const int width, const int height)
+{
+    if (installed) throw runtime_error("GL capture is already recording another context");
+    file = make_unique<ofstream>(path, ios::binary);
+    if (!*file) throw runtime_error("Failed to create GL capture " + path);
+
+#define GL_FUNCTION(name) GlCaptureHook<&glad_##name>::install(#name);
+#include "sevensegmentdisplay/GlFunctions.inc"
+#undef GL_FUNCTION
+
+    write(magic, sizeof(magic));
+    writeString(context);
+    const int32_t size[] = {width, height};
+    write(size, sizeof(size));
+    const auto count = static_cast<uint32_t>(functions.size());
+    write(&count, sizeof(count));
+    for (const string_view name : functions) writeString(name);
+    installed = true;
+}
+
+bool GlCapture::isInstalled()
+{
+    return installed;
+}
+
+void GlCapture::endFrame()
+{
+    write(&frameRecord, sizeof(frameRecord));
+    file->flush();
+}
+
+uint16_t GlCapture::registerFunction(const char* name)
+{
+    if (functions.size() >= mappedWriteRecord) throw runtime_error("GL capture: too many functions");
+    functions.emplace_back(name);
+    return static_cast<uint16_t>(functions.size() - 1);
+}
+
+void GlCapture::beginCall(const uint16_t function, const span<const uint64_t> args)
+{
+    const string_view name = functions[function];
+    // Writes through a coherent mapping never pass through GL, so the bound data is recorded instead
+    if (name == "glBindBufferRange") writeMappedRange(args[2], args[3], args[4]);
+    else if (name == "glUnmapNamedBuffer")
+    {
+        if (const auto mapping = mappings.find(args[0]); mapping != mappings.end())
+        {
+            writeMappedRange(args[0], mapping->second.offset, mapping->second.size);
+            mappings.erase(mapping);
+        }
+    }
+    else if (name == "glMapBufferRange" && (args[3] & GL_MAP_WRITE_BIT))
+    {
+        throw runtime_error("GL capture: write mappings are only supported through glMapNamedBufferRange");
+    }
+    write(&function, sizeof(function));
+}
+
+void GlCapture::endCall(const uint16_t function, const span<const uint64_t> args, const uint64_t result)
+{
+    if (functions[function] == "glMapNamedBufferRange" && result && (args[3] & GL_MAP_WRITE_BIT))
+    {
+        mappings[args[0]] = {reinterpret_cast<const uint8_t*>(result), args[1], args[2]};
+    }
+}
+
+void GlCapture::write(const void* data, const size_t size)
+{
+    file->write(static_cast<const char*>(data), static_cast<streamsize>(size));
+}
+
+uint64_t GlCapture::inputSize(const uint16_t function, const size_t argument, const span<const uint64_t> args)
+{
+    const string_view name = functions[function];
+    const auto text = [&](const size_t index) { return strlen(reinterpret_cast<const char*>(args[index])) + 1; };
+
+    if (name.starts_with("glDelete") && argument == 1) return args[0] * sizeof(GLuint);
+    if (name == "glBufferData" || name == "glNamedBufferData" || name == "glNamedBufferStorage") return args[1];
+    if (name == "glBufferSubData" || name == "glNamedBufferSubData") return args[2];
+    if (name == "glCompressedTexImage2D") return args[6];
+    if (name == "glCompressedTexImage3D" || name == "glCompressedTexSubImage2D") return args[7];
+    if (name == "glCompressedTexSubImage3D") return args[9];
+    if (name == "glTexImage2D") return imageSize(args[3], args[4], 1, args[6], args[7], GL_PIXEL_UNPACK_BUFFER_BINDING);
+    if (name == "glTexImage3D") return imageSize(args[3], args[4], args[5], args[7], args[8], GL_PIXEL_UNPACK_BUFFER_BINDING);
+    if (name == "glTexSubImage2D") return imageSize(args[4], args[5], 1, args[6], args[7], GL_PIXEL_UNPACK_BUFFER_BINDING);
+    if (name == "glTexSubImage3D") return imageSize(args[5], args[6], args[7], args[8], args[9], GL_PIXEL_UNPACK_BUFFER_BINDING);
+    if (name == "glDrawBuffers") return args[0] * sizeof(GLenum);
+    if (name == "glDebugMessageControl") return args[3] * sizeof(GLuint);
+    if (name == "glDebugMessageInsert") return static_cast<GLsizei>(args[4]) < 0 ? text(5) : args[4];
+    if (name == "glGetUniformLocation" || name == "glGetUniformBlockIndex" || name == "glGetAttribLocation" ||
+        name == "glBindAttribLocation" || name == "glBindFragDataLocation")
+    {
+        return text(argument);
+    }
+    if (name.starts_with("glUniform") && name.ends_with("v"))
+    {
+        // glUniform4fv, glUniformMatrix4fv, glUniformMatrix2x3fv
+        const uint64_t elementSize = name.ends_with("dv") ? sizeof(GLdouble) : sizeof(GLfloat);
+        if (!name.starts_with("glUniformMatrix")) return args[1] * (name[9] - '0') * elementSize;
+        const uint64_t columns = name[15] - '0';
+        return args[1] * columns * (name[16] == 'x' ? name[17] - '0' : columns) * elementSize;
+    }
+    // The lengths are folded into the recorded strings
+    if (name == "glShaderSource") return pointerNull;
+    // Offsets into the bound vertex or element buffer
+    if (name == "glDrawElements" || name == "glDrawElementsInstanced" || name == "glVertexAttribPointer" || name == "glVertexAttribIPointer")
+    {
+        return pointerOffset;
+    }
+    if (name == "glDebugMessageCallback") return pointerNull;
+    throw runtime_error("GL capture: cannot size the pointer passed to " + string(name));
+}
+
+uint64_t GlCapture::outputSize(const uint16_t function, const size_t argument, const span<const uint64_t> args)
+{
+    const string_view name = functions[function];
+    if ((name.starts_with("glGen") || name.starts_with("glCreate")) && argument == 1) return args[0] * sizeof(GLuint);
+    if (name == "glGetIntegerv") return (args[0] == GL_VIEWPORT || args[0] == GL_SCISSOR_BOX ? 4 : 1) * sizeof(GLint);
+    if (name == "glGetProgramiv" || name == "glGetShaderiv" || name == "glGetQueryObjectiv" || name == "glGetQueryObjectuiv")
+    {
+        return sizeof(GLint);
+    }
+    if (name == "glGetQueryObjecti64v" || name == "glGetQueryObjectui64v") return sizeof(GLuint64);
+    if (name == "glGetProgramInfoLog" || name == "glGetShaderInfoLog") return argument == 2 ? sizeof(GLsizei) : args[1];
+    if (name == "glReadPixels") return imageSize(args[2], args[3], 1, args[4], args[5], GL_PIXEL_PACK_BUFFER_BINDING);
+    throw runtime_error("GL capture: cannot size the pointer written by " + string(name));
+}
+
+void GlCapture::writeStrings(const uint16_t function, const size_t argument, const span<const uint64_t> args)
+{
+    if (functions[function] != "glShaderSource") throw runtime_error("GL capture: cannot record the strings of " + string(functions[function]));
+    const auto strings = reinterpret_cast<const GLchar* const*>(args[argument]);
+    const auto lengths = reinterpret_cast<const GLint*>(args[argument + 1]);
+    const auto count = static_cast<uint32_t>(args[argument - 1]);
+    write(&count, sizeof(count));
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        writeString(lengths && lengths[i] >= 0 ? string_view(strings[i], lengths[i]) : string_view(strings[i]));
+    }
+}
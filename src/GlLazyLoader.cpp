@@ -0,0 +1,60 @@
+#include "sevensegmentdisplay/GlLazyLoader.hpp"
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+struct LazyStub
+{
+    const char* name;
+    void* call;
+};
+
+static GLADloadproc driverLoader = nullptr;
+static size_t resolved = 0;
+static size_t nextStub = 0;
+
+static void* loadStub(const char* name)
+{
+    // In glad.h declaration order, which is the order gladLoadGLLoader asks for them
+    static const LazyStub stubs[] = {
+#define GL_FUNCTION(function) {#function, GlLazyHook<&glad_##function>::stub(#function)},
+#include "sevensegmentdisplay/GlFunctions.inc"
+#undef GL_FUNCTION
+    };
+    // Almost every request matches the entry after the previous one; the few out of order wrap around
+    for (size_t i = 0; i < size(stubs); ++i)
+    {
+        const size_t index = (nextStub + i) % size(stubs);
+        if (strcmp(stubs[index].name, name) == 0)
+        {
+            nextStub = (index + 1) % size(stubs);
+            return stubs[index].call;
+        }
+    }
+    // Called from glad's C code, so a function without a stub is looked up right away instead of throwing
+    return driverLoader(name);
+}
+
+bool GlLazyLoader::load(const GLADloadproc loader)
+{
+    driverLoader = loader;
+    nextStub = 0;
+    return gladLoadGLLoader(loadStub) != 0;
+}
+
+void* GlLazyLoader::resolve(const char* name)
+{
+    void* address = driverLoader(name);
+    if (!address) throw runtime_error(string(name) + " is not available");
+    resolved++;
+    return address;
+}
+
+size_t GlLazyLoader::getResolved()
+{
+    return resolved;
+}
@@ -0,0 +1,141 @@
+#include "sevensegmentdisplay/GlProfiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+size_t GlProfiler::current = 0;
+
+struct FunctionStats
+{
+    const char* name;
+    uint64_t frameCalls = 0;
+    chrono::steady_clock::duration frameTime{};
+    uint64_t totalCalls = 0;
+    chrono::steady_clock::duration totalTime{};
+};
+
+// Indexed by GlHook::index
+static vector<FunctionStats> functions;
+// Functions called during the current frame
+static vector<size_t> touched;
+static vector<string> debugMessages;
+static bool installed = false;
+static uint64_t frame = 0;
+static unique_ptr<ofstream> file;
+static ostream* report = nullptr;
+
+static double toMs(const chrono::steady_clock::duration duration)
+{
+    return chrono::duration<double, milli>(duration).count();
+}
+
+static void APIENTRY debugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message,
+                                   const void* userParam)
+{
+    // Synchronous output runs inside the call that raised the message
+    debugMessages.push_back(string(functions.empty() ? "?" : functions[GlProfiler::current].name) + ": " +
+                            string(message, length < 0 ? strlen(message) : static_cast<size_t>(length)));
+}
+
+void GlProfiler::install(const string& reportPath)
+{
+    // Later contexts, as with --bench all, keep writing to the report opened for the first one
+    if (!report && reportPath == "-")
+    {
+        report = &cerr;
+    }
+    else if (!report)
+    {
+        file = make_unique<ofstream>(reportPath);
+        if (!*file) throw runtime_error("Failed to create GL profile " + reportPath);
+        report = file.get();
+    }
+
+#define GL_FUNCTION(name) GlHook<&glad_##name>::install(#name);
+#include "sevensegmentdisplay/GlFunctions.inc"
+#undef GL_FUNCTION
+    installed = true;
+}
+
+bool GlProfiler::isInstalled()
+{
+    return installed;
+}
+
+void GlProfiler::enableDebugOutput()
+{
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(debugCallback, nullptr);
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PERFORMANCE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+}
+
+void GlProfiler::endFrame()
+{
+    sort(touched.begin(), touched.end(), [](const size_t a, const size_t b) { return functions[a].frameTime > functions[b].frameTime; });
+    uint64_t calls = 0;
+    chrono::steady_clock::duration time{};
+    for (const size_t function : touched)
+    {
+        calls += functions[function].frameCalls;
+        time += functions[function].frameTime;
+    }
+
+    *report << "frame " << frame << ": " << calls << " calls, " << fixed << setprecision(3) << toMs(time) << " ms in GL\n";
+    for (const size_t function : touched)
+    {
+        FunctionStats& stats = functions[function];
+        *report << "  " << left << setw(28) << stats.name << right << setw(6) << stats.frameCalls << setw(10) << toMs(stats.frameTime) << " ms\n";
+        stats.frameCalls = 0;
+        stats.frameTime = {};
+    }
+    for (const string& message : debugMessages) *report << "  perf " << message << "\n";
+    *report << defaultfloat;
+
+    touched.clear();
+    debugMessages.clear();
+    frame++;
+}
+
+void GlProfiler::printSummary(ostream& out)
+{
+    vector<size_t> order(functions.size());
+    iota(order.begin(), order.end(), 0);
+    erase_if(order, [](const size_t function) { return functions[function].totalCalls == 0; });
+    sort(order.begin(), order.end(), [](const size_t a, const size_t b) { return functions[a].totalTime > functions[b].totalTime; });
+
+    out << "GL calls over " << frame << " frames:\n";
+    for (const size_t function : order)
+    {
+        const FunctionStats& stats = functions[function];
+        out << "  " << left << setw(28) << stats.name << right << setw(10) << stats.totalCalls << " calls" << fixed << setprecision(3)
+            << setw(12) << toMs(stats.totalTime) << " ms" << setw(10) << toMs(stats.totalTime) / max<uint64_t>(frame, 1) << " ms/frame\n"
+            << defaultfloat;
+    }
+}
+
+size_t GlProfiler::registerFunction(const char* name)
+{
+    functions.push_back({name});
+    return functions.size() - 1;
+}
+
+void GlProfiler::record(const size_t function, const chrono::steady_clock::duration elapsed)
+{
+    FunctionStats& stats = functions[function];
+    if (stats.frameCalls == 0) touched.push_back(function);
+    stats.frameCalls++;
+    stats.frameTime += elapsed;
+    stats.totalCalls++;
+    stats.totalTime += elapsed;
+}
@@ -0,0 +1,375 @@
+/*
+    Replays a GL command stream recorded with --gl-capture, to measure the driver's share of a frame
+    without the renderer's own CPU work.
+
+    Usage: ssd_gl_replay <capture> [loops] [skip]
+
+    Issues everything up to the end of frame <skip> (default 1: context setup and the first frame) once,
+    then loops over the remaining frames <loops> times (default 10) in a hidden window, timing each frame.
+    Object names, uniform locations and block indices handed out by the driver must match the capture,
+    otherwise the replay stops with an error.
+*/
+
+#include "sevensegmentdisplay/GlCapture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <GLFW/glfw3.h>
+
+using namespace std;
+
+using Call = function<void()>;
+
+struct CaptureReader
+{
+    const vector<uint8_t>& data;
+    size_t position = 0;
+
+    void bytes(void* out, const size_t size)
+    {
+        if (size > data.size() - position) throw runtime_error("Capture is truncated");
+        memcpy(out, data.data() + position, size);
+        position += size;
+    }
+
+    template <typename T>
+    T read()
+    {
+        T value;
+        bytes(&value, sizeof(value));
+        return value;
+    }
+
+    vector<uint8_t> blob(const uint64_t size)
+    {
+        vector<uint8_t> result(size);
+        bytes(result.data(), size);
+        return result;
+    }
+
+    string text()
+    {
+        string result(read<uint32_t>(), '\0');
+        bytes(result.data(), result.size());
+        return result;
+    }
+};
+
+struct Mapping
+{
+    uint8_t* data;
+    uint64_t offset;
+};
+
+// Captured GLsync values to the ones of this replay
+static unordered_map<uint64_t, GLsync> syncs;
+// Replayed write mappings by buffer name
+static unordered_map<uint64_t, Mapping> mappings;
+
+template <typename T>
+struct ReplayArgument
+{
+    T value{};
+
+    void read(CaptureReader& in) { value = in.read<T>(); }
+    void readOutput(CaptureReader&) {}
+    T get() const { return value; }
+    void check(const string&) const {}
+};
+
+template <typename T>
+    requires isGlFunctionPointer<T>
+struct ReplayArgument<T>
+{
+    void read(CaptureReader&) {}
+    void readOutput(CaptureReader&) {}
+    T get() const { return nullptr; }
+    void check(const string&) const {}
+};
+
+template <>
+struct ReplayArgument<GLsync>
+{
+    uint64_t id = 0;
+
+    void read(CaptureReader& in) { id = in.read<uint64_t>(); }
+    void readOutput(CaptureReader&) {}
+    GLsync get() const { return syncs.at(id); }
+    void check(const string&) const {}
+};
+
+template <>
+struct ReplayArgument<const GLchar* const*>
+{
+    vector<string> strings;
+    vector<const GLchar*> pointers;
+
+    void read(CaptureReader& in)
+    {
+        strings.resize(in.read<uint32_t>());
+        for (string& text : strings)
+        {
+            text = in.text();
+            pointers.push_back(text.c_str());
+        }
+    }
+    void readOutput(CaptureReader&) {}
+    const GLchar* const* get() const { return pointers.data(); }
+    void check(const string&) const {}
+};
+
+// Client data, or an offset into a bound buffer
+template <typename T>
+    requires(std::is_pointer_v<T> && std::is_const_v<std::remove_pointer_t<T>> && !isGlFunctionPointer<T>)
+struct ReplayArgument<T>
+{
+    uint64_t size = 0;
+    uint64_t offset = 0;
+    vector<uint8_t> bytes;
+
+    void read(CaptureReader& in)
+    {
+        size = in.read<uint64_t>();
+        if (size == GlCapture::pointerOffset) offset = in.read<uint64_t>();
+        else if (size != GlCapture::pointerNull) bytes = in.blob(size);
+    }
+    void readOutput(CaptureReader&) {}
+    T get() const
+    {
+        if (size == GlCapture::pointerNull) return nullptr;
+        if (size == GlCapture::pointerOffset) return reinterpret_cast<T>(offset);
+        return reinterpret_cast<T>(bytes.data());
+    }
+    void check(const string&) const {}
+};
+
+// Written by GL; the captured contents are compared for the functions that hand out names
+template <typename T>
+    requires(std::is_pointer_v<T> && !std::is_const_v<std::remove_pointer_t<T>> && !isGlFunctionPointer<T> && !std::is_same_v<T, GLsync>)
+struct ReplayArgument<T>
+{
+    uint64_t size = 0;
+    uint64_t offset = 0;
+    mutable vector<uint8_t> scratch;
+    vector<uint8_t> expected;
+
+    void read(CaptureReader& in)
+    {
+        size = in.read<uint64_t>();
+        if (size == GlCapture::pointerOffset) offset = in.read<uint64_t>();
+        else if (size != GlCapture::pointerNull) scratch.resize(size);
+    }
+    void readOutput(CaptureReader& in)
+    {
+        if (size != GlCapture::pointerOffset && size != GlCapture::pointerNull) expected = in.blob(size);
+    }
+    T get() const
+    {
+        if (size == GlCapture::pointerNull) return nullptr;
+        if (size == GlCapture::pointerOffset) return reinterpret_cast<T>(offset);
+        return reinterpret_cast<T>(scratch.data());
+    }
+    void check(const string& name) const
+    {
+        if (scratch != expected) throw runtime_error(name + " returned other names than in the capture");
+    }
+};
+
+template <auto* Slot, typename Function = std::remove_pointer_t<decltype(Slot)>>
+struct ReplayCall;
+
+template <auto* Slot, typename Result, typename... Args>
+struct ReplayCall<Slot, Result (APIENTRYP)(Args...)>
+{
+    static Call decode(CaptureReader& in, const string& name)
+    {
+        auto arguments = make_shared<tuple<ReplayArgument<Args>...>>();
+        apply([&](auto&... argument) { (argument.read(in), ...); (argument.readOutput(in), ...); }, *arguments);
+        uint64_t recorded = 0;
+        if constexpr (!std::is_void_v<Result> && (!std::is_pointer_v<Result> || std::is_same_v<Result, GLsync>))
+        {
+            recorded = in.read<uint64_t>();
+        }
+        // Later calls refer to objects and locations by the values the renderer got back
+        const bool verify = name.starts_with("glGen") || name.starts_with("glCreate") || name == "glGetUniformLocation" ||
+                            name == "glGetUniformBlockIndex" || name == "glGetAttribLocation";
+
+        return [arguments, recorded, verify, name]
+        {
+            apply([&](const auto&... argument)
+            {
+                if constexpr (std::is_void_v<Result>)
+                {
+                    (*Slot)(argument.get()...);
+                }
+                else
+                {
+                    const Result result = (*Slot)(argument.get()...);
+                    if constexpr (std::is_same_v<Result, GLsync>)
+                    {
+                        syncs[recorded] = result;
+                    }
+                    else if constexpr (std::is_same_v<ReplayCall, ReplayCall<&glad_glMapNamedBufferRange>>)
+                    {
+                        mappings[get<0>(*arguments).value] = {static_cast<uint8_t*>(result), static_cast<uint64_t>(get<1>(*arguments).value)};
+                    }
+                    else if constexpr (!std::is_pointer_v<Result>)
+                    {
+                        if (verify && toCaptureValue(result) != recorded)
+                        {
+                            throw runtime_error(name + " returned " + to_string(toCaptureValue(result)) + ", the capture has " + to_string(recorded));
+                        }
+                    }
+                }
+                if (verify) (argument.check(name), ...);
+            }, *arguments);
+        };
+    }
+};
+
+struct ReplayFunction
+{
+    void** slot;
+    Call (*decode)(CaptureReader& in, const string& name);
+};
+
+static const unordered_map<string, ReplayFunction> replayFunctions = {
+#define GL_FUNCTION(name) {#name, {reinterpret_cast<void**>(&glad_##name), &ReplayCall<&glad_##name>::decode}},
+#include "sevensegmentdisplay/GlFunctions.inc"
+#undef GL_FUNCTION
+};
+
+static Call decodeMappedWrite(CaptureReader& in)
+{
+    const auto buffer = in.read<uint64_t>();
+    const auto offset = in.read<uint64_t>();
+    auto bytes = make_shared<vector<uint8_t>>(in.blob(in.read<uint64_t>()));
+    return [buffer, offset, bytes]
+    {
+        const Mapping& mapping = mappings.at(buffer);
+        memcpy(mapping.data + (offset - mapping.offset), bytes->data(), bytes->size());
+    };
+}
+
+static GLFWwindow* createWindow(const string& context, const int width, const int height)
+{
+    if (!glfwInit()) throw runtime_error("Failed to initialize GLFW");
+    const bool gles = context == "gles30";
+    glfwWindowHint(GLFW_CLIENT_API, gles ? GLFW_OPENGL_ES_API : GLFW_OPENGL_API);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, gles ? GLFW_OPENGL_ANY_PROFILE : GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, gles ? 3 : context == "gl45" ? 4 : 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, gles ? 0 : context == "gl45" ? 5 : 3);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(width, height, "ssd_gl_replay", nullptr, nullptr);
+    if (!window) throw runtime_error("Failed to create a " + context + " context");
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    return window;
+}
+
+static int replay(const string& path, const int loops, const size_t skip)
+{
+    ifstream file(path, ios::binary);
+    if (!file) throw runtime_error("Failed to open " + path);
+    const vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    CaptureReader in{data};
+
+    char magic[sizeof(GlCapture::magic)];
+    in.bytes(magic, sizeof(magic));
+    if (memcmp(magic, GlCapture::magic, sizeof(magic)) != 0) throw runtime_error(path + " is not a GL capture");
+    const string context = in.text();
+    const auto width = in.read<int32_t>();
+    const auto height = in.read<int32_t>();
+    GLFWwindow* window = createWindow(context, width, height);
+
+    // Only the functions in the capture are resolved; ES exposes some of them under extension suffixes
+    vector<const ReplayFunction*> functions(in.read<uint32_t>());
+    vector<string> names(functions.size());
+    for (size_t i = 0; i < functions.size(); ++i)
+    {
+        names[i] = in.text();
+        const auto function = replayFunctions.find(names[i]);
+        if (function == replayFunctions.end()) continue;
+        void* address = nullptr;
+        for (const char* suffix : {"", "KHR", "EXT"})
+        {
+            if ((address = reinterpret_cast<void*>(glfwGetProcAddress((names[i] + suffix).c_str())))) break;
+        }
+        *function->second.slot = address;
+        if (address) functions[i] = &function->second;
+    }
+
+    // The last entry holds the calls after the final frame, the renderer's cleanup, and is never issued
+    vector<vector<Call>> frames(1);
+    while (in.position < data.size())
+    {
+        const auto index = in.read<uint16_t>();
+        if (index == GlCapture::frameRecord) frames.emplace_back();
+        else if (index == GlCapture::mappedWriteRecord) frames.back().push_back(decodeMappedWrite(in));
+        else if (index < functions.size() && functions[index]) frames.back().push_back(functions[index]->decode(in, names[index]));
+        else throw runtime_error("Capture calls " + (index < names.size() ? names[index] : to_string(index)) + ", which is not available here");
+    }
+    frames.pop_back();
+    if (frames.size() <= skip) throw runtime_error(path + " has " + to_string(frames.size()) + " frames, nothing is left after skipping " + to_string(skip));
+
+    for (size_t frame = 0; frame < skip; ++frame)
+    {
+        for (const Call& call : frames[frame]) call();
+    }
+    vector<double> frameTimes;
+    size_t calls = 0;
+    for (int loop = 0; loop < loops; ++loop)
+    {
+        for (size_t frame = skip; frame < frames.size(); ++frame)
+        {
+            // Each frame ends with the renderer's own glFinish, so the time covers the GPU work as well
+            const auto start = chrono::steady_clock::now();
+            for (const Call& call : frames[frame]) call();
+            frameTimes.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            calls += frames[frame].size();
+        }
+    }
+
+    vector<double> sorted = frameTimes;
+    sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (const double t : frameTimes) total += t;
+    auto percentile = [&](const double p) { return sorted[min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))]; };
+    cout << path << ": " << context << " " << width << "x" << height << ", " << frames.size() << " frames, " << calls / frameTimes.size()
+         << " calls/frame\n";
+    cout << "replayed " << frameTimes.size() << " frames, mean " << total / frameTimes.size() << " ms, p50 " << percentile(0.5) << " ms, p99 "
+         << percentile(0.99) << " ms\n";
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
+
+int main(const int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " <capture> [loops] [skip]" << endl;
+        return 1;
+    }
+    try
+    {
+        return replay(argv[1], argc > 2 ? stoi(argv[2]) : 10, argc > 3 ? stoul(argv[3]) : 1);
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,132 @@
+#include "sevensegmentdisplay/GlStateCache.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+void GlStateCache::useProgram(const GLuint program)
+{
+    if (this->program == program)
+    {
+        elided++;
+        return;
+    }
+    glUseProgram(program);
+    this->program = program;
+    issued++;
+}
+
+void GlStateCache::bindVertexArray(const GLuint vao)
+{
+    if (this->vao == vao)
+    {
+        elided++;
+        return;
+    }
+    glBindVertexArray(vao);
+    this->vao = vao;
+    issued++;
+}
+
+void GlStateCache::bindArrayBuffer(const GLuint buffer)
+{
+    if (arrayBuffer == buffer)
+    {
+        elided++;
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    arrayBuffer = buffer;
+    issued++;
+}
+
+void GlStateCache::viewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height)
+{
+    const array<GLint, 4> box{x, y, width, height};
+    if (viewportBox == box)
+    {
+        elided++;
+        return;
+    }
+    glViewport(x, y, width, height);
+    viewportBox = box;
+    issued++;
+}
+
+void GlStateCache::uniform1i(const GLint location, const GLint value)
+{
+    if (updateUniform(location, &value, 1)) glUniform1i(location, value);
+}
+
+void GlStateCache::uniform1f(const GLint location, const GLfloat value)
+{
+    if (updateUniform(location, &value, 1)) glUniform1f(location, value);
+}
+
+void GlStateCache::uniform2f(const GLint location, const GLfloat x, const GLfloat y)
+{
+    const GLfloat value[] = {x, y};
+    if (updateUniform(location, value, 2)) glUniform2f(location, x, y);
+}
+
+void GlStateCache::uniform4f(const GLint location, const GLfloat x, const GLfloat y, const GLfloat z, const GLfloat w)
+{
+    const GLfloat value[] = {x, y, z, w};
+    if (updateUniform(location, value, 4)) glUniform4f(location, x, y, z, w);
+}
+
+void GlStateCache::uniformMatrix4fv(const GLint location, const GLfloat* value)
+{
+    if (updateUniform(location, value, 16)) glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+void GlStateCache::forgetProgram(const GLuint program)
+{
+    uniforms.erase(program);
+    // A deleted program stays in use until another one is bound, so the next useProgram must reach GL
+    if (this->program == program) this->program = ~0u;
+}
+
+void GlStateCache::forgetVertexArray(const GLuint vao)
+{
+    // Deleting the bound vertex array reverts the binding to 0
+    if (this->vao == vao) this->vao = 0;
+}
+
+uint64_t GlStateCache::getIssued() const
+{
+    return issued;
+}
+
+uint64_t GlStateCache::getElided() const
+{
+    return elided;
+}
+
+bool GlStateCache::updateUniform(const GLint location, const void* value, const uint8_t size)
+{
+    if (location < 0)
+    {
+        elided++;
+        return false;
+    }
+    // Nothing is known about a program that was deleted while in use
+    if (program == 0 || program == ~0u)
+    {
+        issued++;
+        return true;
+    }
+
+    vector<UniformValue>& values = uniforms[program];
+    if (values.size() <= static_cast<size_t>(location)) values.resize(location + 1);
+    UniformValue& cached = values[location];
+    if (cached.size == size && memcmp(cached.bits.data(), value, size * sizeof(uint32_t)) == 0)
+    {
+        elided++;
+        return false;
+    }
+    memcpy(cached.bits.data(), value, size * sizeof(uint32_t));
+    cached.size = size;
+    issued++;
+    return true;
+}
@@ -0,0 +1,54 @@
+#include "sevensegmentdisplay/HeadlessRenderer.hpp"
+
+HeadlessRenderer::HeadlessRenderer(const RenderSettings& settings)
+    : screenSize(settings.width, settings.height)
+{
+}
+
+void HeadlessRenderer::drawFrame(const Scene& scene)
+{
+    // Touch the scene so building it cannot be optimised away
+    for (const auto& [points, color] : scene.segments)
+    {
+        checksum += points.size() + static_cast<uint64_t>(color.r);
+    }
+    checksum += scene.digit;
+}
+
+void HeadlessRenderer::present()
+{
+}
+
+void HeadlessRenderer::pollEvents()
+{
+}
+
+void HeadlessRenderer::resize(const int width, const int height)
+{
+    screenSize = vec2(width, height);
+}
+
+bool HeadlessRenderer::isOpen() const
+{
+    return true;
+}
+
+vec2 HeadlessRenderer::getScreenSize() const
+{
+    return screenSize;
+}
+
+const char* HeadlessRenderer::getName() const
+{
+    return "headless";
+}
+
+const char* HeadlessRenderer::getReducedWorkload() const
+{
+    return "builds the scene, draws nothing";
+}
+
+uint64_t HeadlessRenderer::getChecksum() const
+{
+    return checksum;
+}
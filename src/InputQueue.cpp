@@ -0,0 +1,93 @@
+#include "sevensegmentdisplay/InputQueue.hpp"
+#include "sevensegmentdisplay/Main.hpp"
+
+#include <chrono>
+
+using namespace std;
+
+array<InputEvent, InputQueue::capacity> InputQueue::events{};
+size_t InputQueue::count = 0;
+array<InputEvent, InputQueue::historyCapacity> InputQueue::history{};
+size_t InputQueue::historyHead = 0;
+size_t InputQueue::historySize = 0;
+bool InputQueue::historyEnabled = false;
+uint64_t InputQueue::received = 0;
+uint64_t InputQueue::coalesced = 0;
+
+void InputQueue::push(const uint8_t value)
+{
+    received++;
+
+    // Writing the value that is already pending changes nothing
+    if (value == getPending())
+    {
+        coalesced++;
+        return;
+    }
+
+    // When the frame's slots run out, the newest slot absorbs the update so the final value still wins
+    if (count == capacity)
+    {
+        coalesced++;
+        events[count - 1] = {now(), value};
+        return;
+    }
+
+    events[count++] = {now(), value};
+}
+
+bool InputQueue::drain()
+{
+    if (count == 0) return false;
+
+    if (historyEnabled)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            history[historyHead] = events[i];
+            historyHead = (historyHead + 1) % historyCapacity;
+            if (historySize < historyCapacity) historySize++;
+        }
+    }
+
+    // Only the last value of the frame reaches the display state
+    Main::setBits(events[count - 1].value);
+    count = 0;
+    return true;
+}
+
+uint8_t InputQueue::getPending()
+{
+    return count > 0 ? events[count - 1].value : Main::getBits();
+}
+
+void InputQueue::setHistoryEnabled(const bool enabled)
+{
+    historyEnabled = enabled;
+}
+
+size_t InputQueue::getHistorySize()
+{
+    return historySize;
+}
+
+const InputEvent& InputQueue::getHistory(const size_t index)
+{
+    // index 0 is the oldest recorded event
+    return history[(historyHead + historyCapacity - historySize + index) % historyCapacity];
+}
+
+uint64_t InputQueue::getReceived()
+{
+    return received;
+}
+
+uint64_t InputQueue::getCoalesced()
+{
+    return coalesced;
+}
+
+uint64_t InputQueue::now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -1,8 +1,23 @@
 #include "sevensegmentdisplay/Main.hpp"
 #include "sevensegmentdisplay/Renderer.hpp"
+#include "sevensegmentdisplay/BatchDecoder.hpp"
+#include "sevensegmentdisplay/Benchmark.hpp"
+#include "sevensegmentdisplay/FrameExporter.hpp"
+#include "sevensegmentdisplay/GlLazyLoader.hpp"
+#include "sevensegmentdisplay/GlProfiler.hpp"
+#include "sevensegmentdisplay/InputQueue.hpp"
+#include "sevensegmentdisplay/Options.hpp"
+#include "sevensegmentdisplay/Session.hpp"
+#include "sevensegmentdisplay/TerminalRenderer.hpp"
+#include "sevensegmentdisplay/ValueFeed.hpp"
+#include "sevensegmentdisplay/VcdReader.hpp"
+#include "sevensegmentdisplay/ssd_shm.h"
 
 #include <fontconfig/fontconfig.h>
+#include <algorithm>
 #include <chrono>
+#include <fstream>
+#include <memory>
 #include <thread>
 
 using namespace std;
@@ -10,6 +25,9 @@ using namespace glm;
 
 uint8_t Main::bits = 0;
 float Main::frameNum = 0;
+uint8_t Main::overrideMask = 0;
+uint8_t Main::overrideValue = 0;
+float Main::brightness = 1.0f;
 double frameCount = 0;
 double fps = 0.0f;
 
@@ -17,149 +35,218 @@ auto previousTime = std::chrono::high_resolution_clock::now();
 
 auto lastFrame = chrono::high_resolution_clock::now();
 
-constexpr uint8_t digitToSegments[16] = {
-    0b0111111, // 0
-    0b0000110, // 1
-    0b1011011, // 2
-    0b1001111, // 3
-    0b1100110, // 4
-    0b1101101, // 5
-    0b1111101, // 6
-    0b0000111, // 7
-    0b1111111, // 8
-    0b1101111, // 9
-    0b1110111, // A
-    0b1111100, // b
-    0b0111001, // C
-    0b1011110, // d
-    0b1111001, // E
-    0b1110001  // F
-};
-
-vector<vec2> createSegment(const float cx, const float cy, const float length, const float thickness, const float taper)
+int runDecode(const Options& options)
 {
-    return {
-        {cx - length / 2 + taper, cy + thickness / 2},
-        {cx + length / 2 - taper, cy + thickness / 2},
-        {cx + length / 2, cy},
-        {cx + length / 2 - taper, cy - thickness / 2},
-        {cx - length / 2 + taper, cy - thickness / 2},
-        {cx - length / 2, cy}
-    };
-}
+    ofstream file;
+    if (!options.decodeOutput.empty())
+    {
+        file.open(options.decodeOutput, ios::binary);
+        if (!file)
+        {
+            std::cerr << "Failed to open " << options.decodeOutput << std::endl;
+            return -1;
+        }
+    }
 
-vector<vec2> rotate90CCW(const vector<vec2>& points, const float cx, const float cy)
-{
-    vector<vec2> rotated;
-    for (auto& p : points)
+    BatchDecoder decoder(options.decode, options.vcdSignal, options.threads ? options.threads : thread::hardware_concurrency(),
+                         options.decodeFormat, options.decodeOutput.empty() ? cout : file);
+    decoder.run();
+    if (file.is_open())
     {
-        const float dx = p.x - cx;
-        const float dy = p.y - cy;
-        rotated.emplace_back(cx - dy, cy + dx);
+        file.close();
+        if (!file)
+        {
+            std::cerr << "Failed to write " << options.decodeOutput << std::endl;
+            return -1;
+        }
     }
-    return rotated;
-}
 
-vector<vec2> createSquare(const float cx, const float cy, const float size)
-{
-    const float half = size / 2.0f;
-    return {
-            {cx - half, cy - half},
-            {cx + half, cy - half},
-            {cx + half, cy + half},
-            {cx - half, cy + half}
-    };
+    const char* unit = decoder.getSampleUnit();
+    std::cerr << "Decoded " << decoder.getSamples() << " " << unit << " (" << decoder.getBytes() / 1e6 << " MB) into "
+              << decoder.getRunCount() << " runs in " << decoder.getSeconds() << " s: "
+              << decoder.getSamples() / decoder.getSeconds() / 1e6 << " M " << unit << "/s" << std::endl;
+    return 0;
 }
 
-array<Segment, 7> calculateSegments(const vec2 screenSize, const uint8_t segmentValue)
+int main(int argc, char** argv)
 {
-    array<Segment, 7> segments;
-    const float centerX = screenSize.x / 2.0f;
-    const float yOffset = screenSize.y * -0.07;
-    const float centerY = screenSize.y / 2.0f + yOffset;
-
-    const float segmentLength = screenSize.y * 0.25f;
-    const float thickness = screenSize.y * 0.06f;
-
-
-    const float verticalX = segmentLength / 2 + thickness / 2;
-    const float upperVerticalY = centerY - segmentLength / 2 - thickness / 2;
-    const float lowerVerticalY = centerY + segmentLength / 2 + thickness / 2;
-
-    segments[0].points = createSegment(centerX, centerY - segmentLength - thickness, segmentLength, thickness, 0);
-    segments[3].points = createSegment(centerX, centerY + segmentLength + thickness, segmentLength, thickness, 0);
-    segments[6].points = createSegment(centerX, centerY, segmentLength, thickness, 0);
-
-
-    segments[1].points = rotate90CCW(
-        createSegment(centerX + verticalX, upperVerticalY, segmentLength, thickness, 0),
-        centerX + verticalX, upperVerticalY);
-    segments[2].points = rotate90CCW(
-        createSegment(centerX + verticalX, lowerVerticalY, segmentLength, thickness, 0),
-        centerX + verticalX, lowerVerticalY);
-    segments[4].points = rotate90CCW(
-        createSegment(centerX - verticalX, lowerVerticalY, segmentLength, thickness, 0),
-        centerX - verticalX, lowerVerticalY);
-    segments[5].points = rotate90CCW(
-        createSegment(centerX - verticalX, upperVerticalY, segmentLength, thickness, 0),
-        centerX - verticalX, upperVerticalY);
-
-    const uint8_t segBits = digitToSegments[segmentValue & 0xF];
-    for (int i = 0; i < 7; ++i)
+    Options options;
+    unique_ptr<ValueFeed> feed;
+    ssd_shm shm{};
+    // Unlinks the segment on every way out of main, so readers never attach to a display that already exited
+    auto closeShm = [](ssd_shm* segment) { if (segment->state) ssd_shm_close(segment); };
+    const unique_ptr<ssd_shm, decltype(closeShm)> shmGuard(&shm, closeShm);
+    ssd_display_state shmState{};
+    uint32_t shmSequence = 0;
+    unique_ptr<VcdReader> vcd;
+    unique_ptr<SessionReplay> replay;
+    try
     {
-        const bool isOn = (segBits >> i) & 1;
-        segments[i].color = isOn ? vec3(1.0f, 0.0f, 0.0f) : vec3(1.0f);
+        options = Options::parse(argc, argv);
+        if (!options.decode.empty()) return runDecode(options);
+        if (options.bench || options.noiseReport)
+        {
+            RenderSettings settings;
+            settings.bloom = RenderBackend::bloomFromName(options.bloom);
+            settings.noise = RenderBackend::noiseFromName(options.noise);
+            settings.temporal = options.temporal;
+            settings.flipbookLayers = options.flipbook;
+            settings.profile = RenderBackend::profileFromName(options.profile);
+            settings.glProfile = options.glProfile;
+            settings.glCapture = options.glCapture;
+            settings.lazyGl = options.glLazy;
+            if (options.noiseReport) return Benchmark::compareNoise(options.backend, options.noiseReport, settings);
+            return Benchmark::run(options.backend, options.bench, settings);
+        }
+        if (!options.feed.empty()) feed = make_unique<ValueFeed>(options.feed);
+        if (!options.shm.empty() && ssd_shm_open(&shm, options.shm.c_str(), 1) != 0)
+        {
+            throw runtime_error("Failed to create shared memory segment " + options.shm);
+        }
+        if (!options.vcd.empty())
+        {
+            vcd = make_unique<VcdReader>(options.vcd, options.vcdSignal);
+            vcd->seek(options.vcdSeek);
+            InputQueue::push(vcd->getValue());
+        }
+        if (!options.replay.empty()) replay = make_unique<SessionReplay>(options.replay);
     }
-    return segments;
-}
-
-auto calculateBitIndicators(const vec2 screenSize)
-{
-
-    array<Segment, 7> segments;
-    const float centerX = screenSize.x / 2.0f;
-    const float yOffset = screenSize.y * -0.07;
-    const float centerY = screenSize.y / 2.0f + yOffset;
-
-    const float segmentLength = screenSize.y * 0.25f;
-    const float thickness = screenSize.y * 0.06f;
-
-    const float squareSize = screenSize.y * 0.06f;
-    const float gap = screenSize.x * 0.01f;
-
-    const float baseY = centerY + segmentLength + thickness * 3.0f + 20.0f;
-
-    const float totalWidth = squareSize * 4 + gap * 3;
-    const float startX = centerX - totalWidth / 2 + squareSize / 2;
-
-    vector<vector<vec2>>  bitIndicators(4);
-    for (int i = 0; i < 4; ++i)
+    catch (const exception& e)
     {
-        const float x = startX + i * (squareSize + gap);
-        bitIndicators[i] = createSquare(x, baseY, squareSize);
+        std::cerr << e.what() << std::endl;
+        return -1;
     }
-    return bitIndicators;
-}
+    InputQueue::setHistoryEnabled(options.history);
+
+    auto playbackStart = chrono::steady_clock::now();
+    auto pollSources = [&]
+    {
+        if (uint8_t feedValue; feed && feed->poll(feedValue)) InputQueue::push(feedValue);
+        // One acquire load per frame; the state is only copied when a producer wrote something
+        if (shm.state && ssd_shm_read(&shm, &shmSequence, &shmState))
+        {
+            InputQueue::push(shmState.digits[0] & 0xF);
+            Main::setSegmentOverride(shmState.segment_mask[0], shmState.segment_value[0]);
+            Main::setBrightness(shmState.brightness);
+        }
+        if (vcd)
+        {
+            // Wall-clock seconds scaled to simulated seconds, then to VCD time units
+            const double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - playbackStart).count();
+            const auto simTime = options.vcdSeek + static_cast<uint64_t>(wallSeconds * options.vcdSpeed / vcd->getTimescale());
+            if (vcd->advanceTo(simTime)) InputQueue::push(vcd->getValue());
+        }
+        InputQueue::drain();
+    };
 
-int main()
-{
     if (!FcInit()) {
         std::cerr << "Failed to initialize Fontconfig!" << std::endl;
         return -1;
     }
 
-    const auto* renderer = new Renderer(500, 700, "Sieben-Segment-Display");
-    GLFWwindow* window = renderer->getWindow();
-    while (!glfwWindowShouldClose(window))
+    RenderSettings settings;
+    settings.terminalFps = options.terminalFps;
+    if (replay)
     {
-
-
-
-        renderer->drawFrame(calculateSegments(Renderer::getScreenSize(), Main::getBits()), calculateBitIndicators(Renderer::getScreenSize()));
-
-        glfwSwapBuffers(window);
-        glFinish();
-        glfwPollEvents();
+        settings.width = replay->getWidth();
+        settings.height = replay->getHeight();
+        settings.visible = false;
+        settings.vsync = !options.replayFast;
+    }
+    unique_ptr<RenderBackend> renderer;
+    try
+    {
+        settings.bloom = RenderBackend::bloomFromName(options.bloom);
+        settings.noise = RenderBackend::noiseFromName(options.noise);
+        settings.temporal = options.temporal;
+        settings.flipbookLayers = options.flipbook;
+        settings.profile = RenderBackend::profileFromName(options.profile);
+        settings.glProfile = options.glProfile;
+        settings.glCapture = options.glCapture;
+        settings.lazyGl = options.glLazy;
+        // Baking happens while the renderer is created; nothing needs to be shown
+        if (options.bakeFlipbook) settings.visible = false;
+        renderer = RenderBackend::create(options.backend, settings);
+    }
+    catch (const exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    if (options.bakeFlipbook)
+    {
+        if (renderer->hasGlContext()) return 0;
+        std::cerr << "Baking the flipbook needs an OpenGL backend" << std::endl;
+        return -1;
+    }
+    if (!options.record.empty())
+    {
+        const vec2 screenSize = renderer->getScreenSize();
+        try
+        {
+            Session::startRecording(options.record, static_cast<int>(screenSize.x), static_cast<int>(screenSize.y));
+        }
+        catch (const exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return -1;
+        }
+    }
+    unique_ptr<FrameExporter> exporter;
+    if (!options.exportPath.empty())
+    {
+        if (!renderer->hasGlContext())
+        {
+            std::cerr << "Exporting needs an OpenGL backend" << std::endl;
+            return -1;
+        }
+        const vec2 screenSize = renderer->getScreenSize();
+        try
+        {
+            // One core stays with the render loop; hardware_concurrency may report 0
+            exporter = make_unique<FrameExporter>(options.exportPath,
+                                                  FrameExporter::formatFromName(options.exportFormat.empty() ? options.exportPath : options.exportFormat),
+                                                  static_cast<int>(screenSize.x), static_cast<int>(screenSize.y), options.exportFps,
+                                                  options.threads ? options.threads : max(2u, thread::hardware_concurrency()) - 1);
+        }
+        catch (const exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return -1;
+        }
+    }
+    vector<float> frameTimes;
+    int exitCode = 0;
+    playbackStart = chrono::steady_clock::now();
+    while (renderer->isOpen() && !(replay && replay->isFinished()) && !(options.frames && Main::getFrame() >= options.frames))
+    {
+        const auto frameStart = chrono::steady_clock::now();
+        pollSources();
+
+        renderer->drawFrame(buildScene(renderer->getScreenSize(), renderer->needsGeometry()));
+        if (exporter) exporter->capture();
+
+        renderer->present();
+        if (replay) frameTimes.push_back(chrono::duration<float, milli>(chrono::steady_clock::now() - frameStart).count());
+
+        if (replay)
+        {
+            try
+            {
+                replay->dispatchFrame(*renderer, !options.replayFast);
+            }
+            catch (const exception& e)
+            {
+                std::cerr << e.what() << std::endl;
+                exitCode = -1;
+                break;
+            }
+        }
+        else
+        {
+            renderer->pollEvents();
+            Session::recordFrame();
+        }
         (*Main::getFramePtr())++;
 
         frameCount++;
@@ -170,14 +257,62 @@ int main()
             previousTime = std::chrono::high_resolution_clock::now();
 #ifdef DEBUG_MODE
             cout << "FPS " << fps << "\n";
+            cout << "Input events " << InputQueue::getReceived() << " (coalesced " << InputQueue::getCoalesced() << ")\n";
+            if (feed) cout << "Feed messages " << feed->getMessages() << "\n";
+            if (exporter) cout << "Capture " << exporter->getAverageCaptureMs() << " ms/frame, dropped " << exporter->getDropped() << "\n";
+            if (const auto* gl = dynamic_cast<const Renderer*>(renderer.get()))
+            {
+                if (gl->getBloomMs() > 0) cout << "Bloom " << gl->getBloomMs() << " ms/frame GPU\n";
+                cout << "GL state calls " << gl->getStateCache().getIssued() << " (elided " << gl->getStateCache().getElided() << ")\n";
+                if (options.glLazy) cout << "GL entry points resolved " << GlLazyLoader::getResolved() << "\n";
+            }
+            if (options.history)
+            {
+                cout << "History";
+                const size_t historySize = InputQueue::getHistorySize();
+                for (size_t i = historySize > 16 ? historySize - 16 : 0; i < historySize; ++i)
+                {
+                    cout << " " << hex << static_cast<int>(InputQueue::getHistory(i).value) << dec;
+                }
+                cout << "\n";
+            }
 #endif
         }
     }
 
-    delete renderer;
+    Session::stopRecording();
+    if (exporter)
+    {
+        exporter->finish();
+        cout << "Exported " << exporter->getCaptured() << " frames (" << exporter->getDropped() << " dropped), capture overhead "
+             << exporter->getAverageCaptureMs() << " ms/frame\n";
+        if (exporter->getFailed() > 0)
+        {
+            std::cerr << "Failed to write " << exporter->getFailed() << " exported frames to " << options.exportPath << std::endl;
+            exitCode = -1;
+        }
+        exporter.reset();
+    }
+    if (replay && !frameTimes.empty())
+    {
+        vector<float> sorted = frameTimes;
+        sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (const float t : frameTimes) total += t;
+        auto percentile = [&](const double p) { return sorted[min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))]; };
+        cout << "Replayed " << frameTimes.size() << " frames: mean " << total / frameTimes.size() << " ms, p50 "
+             << percentile(0.5) << " ms, p95 " << percentile(0.95) << " ms, p99 " << percentile(0.99) << " ms, max "
+             << sorted.back() << " ms\n";
+    }
 
+    if (GlProfiler::isInstalled()) GlProfiler::printSummary(cout);
 
-    return 0;
+    const auto* terminal = dynamic_cast<const TerminalRenderer*>(renderer.get());
+    const uint64_t bytesWritten = terminal ? terminal->getBytesWritten() : 0;
+    renderer.reset();
+    if (terminal) cout << "Terminal frames " << Main::getFrame() << ", " << bytesWritten << " bytes written\n";
+
+    return exitCode;
 }
 
 uint8_t Main::getBits()
@@ -199,3 +334,24 @@ void Main::setBits(const uint8_t& newBits)
 {
     bits = newBits;
 }
+
+void Main::setSegmentOverride(const uint8_t mask, const uint8_t value)
+{
+    overrideMask = mask;
+    overrideValue = value;
+}
+
+uint8_t Main::applySegmentOverride(const uint8_t segments)
+{
+    return (segments & ~overrideMask) | (overrideValue & overrideMask);
+}
+
+void Main::setBrightness(const float newBrightness)
+{
+    brightness = newBrightness;
+}
+
+float Main::getBrightness()
+{
+    return brightness;
+}
@@ -0,0 +1,176 @@
+#include "sevensegmentdisplay/Options.hpp"
+#include "sevensegmentdisplay/Flipbook.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+Options Options::parse(const int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        auto value = [&]() -> string
+        {
+            if (i + 1 >= argc) throw invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "--history")
+        {
+            options.history = true;
+        }
+        else if (arg == "--feed")
+        {
+            options.feed = value();
+        }
+        else if (arg == "--shm")
+        {
+            options.shm = value();
+        }
+        else if (arg == "--vcd")
+        {
+            options.vcd = value();
+        }
+        else if (arg == "--vcd-signal")
+        {
+            options.vcdSignal = value();
+        }
+        else if (arg == "--vcd-speed")
+        {
+            options.vcdSpeed = stod(value());
+        }
+        else if (arg == "--vcd-seek")
+        {
+            options.vcdSeek = stoull(value());
+        }
+        else if (arg == "--decode")
+        {
+            options.decode = value();
+        }
+        else if (arg == "--decode-format")
+        {
+            options.decodeFormat = value();
+            if (options.decodeFormat != "rle" && options.decodeFormat != "vcd")
+            {
+                throw invalid_argument("Unknown decode format: " + options.decodeFormat);
+            }
+        }
+        else if (arg == "--decode-output")
+        {
+            options.decodeOutput = value();
+        }
+        else if (arg == "--threads")
+        {
+            options.threads = stoul(value());
+        }
+        else if (arg == "--record")
+        {
+            options.record = value();
+        }
+        else if (arg == "--replay")
+        {
+            options.replay = value();
+        }
+        else if (arg == "--replay-fast")
+        {
+            options.replayFast = true;
+        }
+        else if (arg == "--export")
+        {
+            options.exportPath = value();
+        }
+        else if (arg == "--export-format")
+        {
+            options.exportFormat = value();
+        }
+        else if (arg == "--export-fps")
+        {
+            options.exportFps = stoi(value());
+        }
+        else if (arg == "--terminal")
+        {
+            options.backend = "terminal";
+        }
+        else if (arg == "--terminal-fps")
+        {
+            options.terminalFps = stoi(value());
+        }
+        else if (arg == "--backend")
+        {
+            options.backend = value();
+        }
+        else if (arg == "--frames")
+        {
+            options.frames = stoull(value());
+        }
+        else if (arg == "--bench")
+        {
+            options.bench = stoull(value());
+        }
+        else if (arg == "--bloom")
+        {
+            options.bloom = value();
+        }
+        else if (arg == "--noise")
+        {
+            options.noise = value();
+        }
+        else if (arg == "--noise-report")
+        {
+            options.noiseReport = stoull(value());
+        }
+        else if (arg == "--temporal")
+        {
+            options.temporal = true;
+        }
+        else if (arg == "--flipbook")
+        {
+            options.flipbook = stoi(value());
+            if (options.flipbook < Flipbook::correlatedLayers())
+            {
+                // Fewer layers cross-fade between unrelated patterns instead of following the animation
+                throw invalid_argument("--flipbook needs at least " + to_string(Flipbook::correlatedLayers()) + " layers");
+            }
+        }
+        else if (arg == "--profile")
+        {
+            options.profile = value();
+        }
+        else if (arg == "--gl-profile")
+        {
+            options.glProfile = value();
+        }
+        else if (arg == "--gl-capture")
+        {
+            options.glCapture = value();
+        }
+        else if (arg == "--gl-lazy")
+        {
+            options.glLazy = true;
+        }
+        else if (arg == "--bake-flipbook")
+        {
+            options.bakeFlipbook = true;
+        }
+        else
+        {
+            throw invalid_argument("Unknown option: " + arg);
+        }
+    }
+    if (!options.record.empty() && !options.replay.empty())
+    {
+        throw invalid_argument("--record and --replay cannot be combined");
+    }
+    if (options.flipbook && options.temporal)
+    {
+        throw invalid_argument("--flipbook and --temporal cannot be combined");
+    }
+    if (options.bakeFlipbook && !options.flipbook)
+    {
+        throw invalid_argument("--bake-flipbook needs --flipbook");
+    }
+    return options;
+}
@@ -0,0 +1,114 @@
+#include "sevensegmentdisplay/RenderBackend.hpp"
+#include "sevensegmentdisplay/HeadlessRenderer.hpp"
+#include "sevensegmentdisplay/Renderer.hpp"
+#include "sevensegmentdisplay/SoftwareRenderer.hpp"
+#include "sevensegmentdisplay/TerminalRenderer.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+
+using namespace std;
+
+unique_ptr<RenderBackend> RenderBackend::create(const string& name, const RenderSettings& settings)
+{
+    if (name == "gl33") return make_unique<Renderer>(settings, Renderer::GlVersion::Gl33);
+    if (name == "gl45") return make_unique<Renderer>(settings, Renderer::GlVersion::Gl45);
+    if (name == "gles30") return make_unique<Renderer>(settings, Renderer::GlVersion::Gles30);
+    if (name == "procedural") return make_unique<Renderer>(settings, Renderer::GlVersion::Gl45, Renderer::Geometry::Procedural);
+    if (name == "software") return make_unique<SoftwareRenderer>(settings);
+    if (name == "headless") return make_unique<HeadlessRenderer>(settings);
+    if (name == "terminal") return make_unique<TerminalRenderer>(settings);
+    throw invalid_argument("Unknown backend: " + name);
+}
+
+BloomQuality RenderBackend::bloomFromName(const string& name)
+{
+    if (name == "off") return BloomQuality::Off;
+    if (name == "low") return BloomQuality::Low;
+    if (name == "medium") return BloomQuality::Medium;
+    if (name == "high") return BloomQuality::High;
+    throw invalid_argument("Unknown bloom quality: " + name);
+}
+
+NoiseKernel RenderBackend::noiseFromName(const string& name)
+{
+    if (name == "sin") return NoiseKernel::Sine;
+    if (name == "int") return NoiseKernel::IntegerHash;
+    throw invalid_argument("Unknown noise kernel: " + name);
+}
+
+QualityProfile RenderBackend::profileFromName(const string& name)
+{
+    if (name == "custom") return QualityProfile::Custom;
+    if (name == "auto") return QualityProfile::Auto;
+    if (name == "minimal") return QualityProfile::Minimal;
+    if (name == "low") return QualityProfile::Low;
+    if (name == "medium") return QualityProfile::Medium;
+    if (name == "high") return QualityProfile::High;
+    throw invalid_argument("Unknown quality profile: " + name);
+}
+
+const char* RenderBackend::getProfileName(const QualityProfile profile)
+{
+    switch (profile)
+    {
+    case QualityProfile::Custom: return "custom";
+    case QualityProfile::Auto: return "auto";
+    case QualityProfile::Minimal: return "minimal";
+    case QualityProfile::Low: return "low";
+    case QualityProfile::Medium: return "medium";
+    case QualityProfile::High: return "high";
+    }
+    return "custom";
+}
+
+void RenderBackend::applyProfile(const QualityProfile profile, RenderSettings& settings)
+{
+    switch (profile)
+    {
+    case QualityProfile::High:
+        settings.noise = NoiseKernel::Sine;
+        settings.maxOctaves = 14;
+        settings.temporal = false;
+        settings.bloom = BloomQuality::Medium;
+        break;
+    case QualityProfile::Medium:
+        settings.noise = NoiseKernel::IntegerHash;
+        settings.maxOctaves = 14;
+        settings.temporal = false;
+        settings.bloom = BloomQuality::Low;
+        break;
+    // Single pass over half the pixels per frame; the flipbook already skips the noise, so it keeps priority
+    case QualityProfile::Low:
+        settings.noise = NoiseKernel::IntegerHash;
+        settings.maxOctaves = 10;
+        settings.temporal = settings.flipbookLayers == 0;
+        settings.bloom = BloomQuality::Off;
+        break;
+    case QualityProfile::Minimal:
+        settings.noise = NoiseKernel::IntegerHash;
+        settings.maxOctaves = 6;
+        settings.temporal = settings.flipbookLayers == 0;
+        settings.bloom = BloomQuality::Off;
+        break;
+    case QualityProfile::Custom:
+    case QualityProfile::Auto:
+        break;
+    }
+}
+
+string RenderBackend::getCacheDirectory()
+{
+    filesystem::path directory;
+    if (const char* cacheHome = getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome) directory = cacheHome;
+    else if (const char* home = getenv("HOME"); home && *home) directory = filesystem::path(home) / ".cache";
+    else directory = filesystem::temp_directory_path();
+    return (directory / "sevensegmentdisplay").string();
+}
+
+const vector<string>& RenderBackend::getNames()
+{
+    static const vector<string> names = {"gl33", "gl45", "gles30", "procedural", "software", "headless", "terminal"};
+    return names;
+}
@@ -1,20 +1,29 @@
 #include "sevensegmentdisplay/Renderer.hpp"
 #include "sevensegmentdisplay/Main.hpp"
-
+#include "sevensegmentdisplay/Flipbook.hpp"
+#include "sevensegmentdisplay/GlCapture.hpp"
+#include "sevensegmentdisplay/GlLazyLoader.hpp"
+#include "sevensegmentdisplay/GlProfiler.hpp"
+#include "sevensegmentdisplay/InputQueue.hpp"
+#include "sevensegmentdisplay/Session.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <future>
+#include <string_view>
+#include <unistd.h>
 
 using namespace std;
 using namespace glm;
 
 
-mat4 projection;
-GLFWwindow* window;
-vec2 Renderer::screenSize = vec2(0);
-
-GLuint shaderProgram;
-GLuint vao, vbo;
-GLint projectionLoc;
-
 GLuint compileShader(const GLenum type, const std::string& src)
 {
     const GLuint shader = glCreateShader(type);
@@ -35,11 +44,63 @@ GLuint compileShader(const GLenum type, const std::string& src)
     return shader;
 }
 
+GLuint linkProgram(const std::string& vertexSrc, const std::string& fragmentSrc)
+{
+    const GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSrc);
+    const GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSrc);
+
+    const GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+    if (!success)
+    {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+        cerr << "Shader Program linking failed: " << infoLog << "\n";
+        throw runtime_error("Shader Program linking failed");
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+void loadGles30EntryPoints(const GLADloadproc load)
+{
+    glad_glDrawArraysInstanced = reinterpret_cast<PFNGLDRAWARRAYSINSTANCEDPROC>(load("glDrawArraysInstanced"));
+    glad_glDrawElementsInstanced = reinterpret_cast<PFNGLDRAWELEMENTSINSTANCEDPROC>(load("glDrawElementsInstanced"));
+    glad_glCopyBufferSubData = reinterpret_cast<PFNGLCOPYBUFFERSUBDATAPROC>(load("glCopyBufferSubData"));
+    glad_glGetUniformBlockIndex = reinterpret_cast<PFNGLGETUNIFORMBLOCKINDEXPROC>(load("glGetUniformBlockIndex"));
+    glad_glUniformBlockBinding = reinterpret_cast<PFNGLUNIFORMBLOCKBINDINGPROC>(load("glUniformBlockBinding"));
+    glad_glBindBufferRange = reinterpret_cast<PFNGLBINDBUFFERRANGEPROC>(load("glBindBufferRange"));
+    glad_glBindBufferBase = reinterpret_cast<PFNGLBINDBUFFERBASEPROC>(load("glBindBufferBase"));
+    glad_glFenceSync = reinterpret_cast<PFNGLFENCESYNCPROC>(load("glFenceSync"));
+    glad_glClientWaitSync = reinterpret_cast<PFNGLCLIENTWAITSYNCPROC>(load("glClientWaitSync"));
+    glad_glDeleteSync = reinterpret_cast<PFNGLDELETESYNCPROC>(load("glDeleteSync"));
+    glad_glGetInteger64v = reinterpret_cast<PFNGLGETINTEGER64VPROC>(load("glGetInteger64v"));
+}
+
+bool hasGlExtension(const string_view name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        if (name == reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))) return true;
+    }
+    return false;
+}
+
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     if (action == GLFW_PRESS || action == GLFW_REPEAT)
     {
-        uint8_t inputBits = Main::getBits();
+        uint8_t inputBits = InputQueue::getPending();
         switch (key)
         {
         case GLFW_KEY_F4:
@@ -65,31 +126,56 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
             }
             break;
         }
-        Main::setBits(inputBits);
+        InputQueue::push(inputBits);
     }
 }
 
-void resizeCallback(GLFWwindow* window, int width, int height)
-{
-    glViewport(0, 0, width, height);
-    Renderer::setScreenSize({width, height});
-    projection = ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f);
-    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, value_ptr(projection));
-}
-
-Renderer::Renderer(const int& width, const int& height, const char* title)
+Renderer::Renderer(const RenderSettings& settings, const GlVersion requested, const Geometry geometry)
+    : version(requested), geometry(geometry), bloom(settings.bloom), temporal(settings.temporal),
+      flipbookLayers(settings.flipbookLayers)
 {
     if (!glfwInit())
     {
         throw runtime_error("Failed to initialize GLFW");
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    const bool gles = version == GlVersion::Gles30;
+    glfwWindowHint(GLFW_CLIENT_API, gles ? GLFW_OPENGL_ES_API : GLFW_OPENGL_API);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, gles ? GLFW_OPENGL_ANY_PROFILE : GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, settings.visible ? GLFW_TRUE : GLFW_FALSE);
+    // Drivers are only required to report performance messages in debug contexts
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, settings.glProfile.empty() ? GLFW_FALSE : GLFW_TRUE);
 
-    window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    window = nullptr;
+    if (gles)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+        window = glfwCreateWindow(settings.width, settings.height, settings.title, nullptr, nullptr);
+        if (!window)
+        {
+            glfwTerminate();
+            throw runtime_error("Failed to create OpenGL ES 3.0 context");
+        }
+    }
+    else if (version == GlVersion::Gl45)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        window = glfwCreateWindow(settings.width, settings.height, settings.title, nullptr, nullptr);
+        if (!window)
+        {
+            cerr << "OpenGL 4.5 context not available, falling back to 3.3\n";
+            version = GlVersion::Gl33;
+        }
+    }
+    if (!window)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(settings.width, settings.height, settings.title, nullptr, nullptr);
+    }
     if (!window)
     {
         glfwTerminate();
@@ -97,53 +183,196 @@ Renderer::Renderer(const int& width, const int& height, const char* title)
     }
 
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
-
-    glfwSetKeyCallback(window, keyCallback);
-    glfwSetFramebufferSizeCallback(window, resizeCallback);
-
+    glfwSwapInterval(settings.vsync ? 1 : 0);
+    glfwSetWindowUserPointer(window, this);
 
+    // Only events coming from GLFW are recorded, not the renderer's own resize calls
+    glfwSetKeyCallback(window, [](GLFWwindow* w, const int key, const int scancode, const int action, const int mods)
+    {
+        Session::recordKey(key, scancode, action, mods);
+        keyCallback(w, key, scancode, action, mods);
+    });
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* w, const int newWidth, const int newHeight)
+    {
+        Session::recordResize(newWidth, newHeight);
+        static_cast<Renderer*>(glfwGetWindowUserPointer(w))->resize(newWidth, newHeight);
+    });
 
-    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+    const auto loader = reinterpret_cast<GLADloadproc>(glfwGetProcAddress);
+    if (!(settings.lazyGl ? GlLazyLoader::load(loader) : gladLoadGLLoader(loader)))
     {
         throw runtime_error("Failed to initialize GLAD");
     }
+    if (gles)
+    {
+        // The loader parses "OpenGL ES x.y" version strings, but files these ES 3.0 entry points under GL 3.1/3.2
+        if (GLVersion.major < 3) throw runtime_error("OpenGL ES 3.0 is not available");
+        loadGles30EntryPoints(loader);
+        // Timer results and debug output come from extensions on ES, under suffixed names
+        if (hasGlExtension("GL_EXT_disjoint_timer_query"))
+        {
+            glad_glGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VPROC>(glfwGetProcAddress("glGetQueryObjectui64vEXT"));
+        }
+        if (hasGlExtension("GL_KHR_debug"))
+        {
+            glad_glDebugMessageCallback = reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(glfwGetProcAddress("glDebugMessageCallbackKHR"));
+            glad_glDebugMessageControl = reinterpret_cast<PFNGLDEBUGMESSAGECONTROLPROC>(glfwGetProcAddress("glDebugMessageControlKHR"));
+        }
+    }
+    else if (!glad_glDebugMessageCallback && hasGlExtension("GL_KHR_debug"))
+    {
+        glad_glDebugMessageCallback = reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(glfwGetProcAddress("glDebugMessageCallback"));
+        glad_glDebugMessageControl = reinterpret_cast<PFNGLDEBUGMESSAGECONTROLPROC>(glfwGetProcAddress("glDebugMessageControl"));
+    }
+    // Buffer storage is core since 4.4, so a 4.5 context has everything the fast path needs
+    if (version == GlVersion::Gl45 && !GLAD_GL_VERSION_4_5)
+    {
+        cerr << "OpenGL 4.5 functions not available, falling back to 3.3\n";
+        version = GlVersion::Gl33;
+    }
+    // Every pointer is resolved at this point, so the wrappers cover all later calls
+    if (!settings.glProfile.empty())
+    {
+        GlProfiler::install(settings.glProfile);
+        if (glad_glDebugMessageCallback && glad_glDebugMessageControl) GlProfiler::enableDebugOutput();
+        else cerr << "KHR_debug not available, the GL profile has no driver messages\n";
+    }
+    if (!settings.glCapture.empty())
+    {
+        // The replayer needs the context version, which the procedural backend shares with gl45/gl33
+        const char* context = gles ? "gles30" : version == GlVersion::Gl45 ? "gl45" : "gl33";
+        GlCapture::install(settings.glCapture, context, settings.width, settings.height);
+    }
 
-    int framebufferWidth = width, framebufferHeight = height;
-    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
-    resizeCallback(window, framebufferWidth, framebufferHeight);
-
-    constexpr auto vertexShaderSrc = R"glsl(
+    // Shared by both vertex shaders: per-element state and the transition between two colors
+    constexpr auto vertexHeaderSrc = R"glsl(
     #version 330 core
-    layout(location = 0) in vec2 aPos;      // vertex position input
-    layout(location = 1) in vec2 aUV;       // UV input
-    layout(location = 2) in vec3 aColor;    // vertex color input
+    struct Element
+    {
+        vec4 color;                         // rgb, w = frame of the last change
+        vec4 previous;                      // rgb before the change, w = fade duration in frames
+    };
+
+    layout(std140) uniform Elements
+    {
+        Element elements[16];
+    };
 
+    out vec3 fragColor;                     // pass to fragment shader
+    flat out vec3 fragPrevious;
+    flat out float fragBlend;               // 0 shows fragPrevious, 1 shows fragColor
+    uniform float time;
+
+    void passElement(int index)
+    {
+        Element element = elements[index];
+        fragColor = element.color.rgb;
+        fragPrevious = element.previous.rgb;
+        fragBlend = smoothstep(0.0, 1.0, (time - element.color.w) / element.previous.w);
+    }
+    )glsl";
+
+    constexpr auto vertexShaderSrc = R"glsl(
+    layout(location = 0) in vec2 aPos;      // position normalized to the screen, doubles as the UV
+    layout(location = 1) in uint aElement;  // index into the element block
 
     out vec2 fragUV;
-    out vec3 fragColor;                     // pass to fragment shader
     uniform mat4 projection;                // uniform projection matrix
+    uniform vec2 resolution;
 
     void main()
     {
-        gl_Position = projection * vec4(aPos, 0.0, 1.0);
-        fragUV = aUV;
-        fragColor = aColor;
+        gl_Position = projection * vec4(aPos * resolution, 0.0, 1.0);
+        fragUV = aPos;
+        passElement(int(aElement));
     }
     )glsl";
 
-    constexpr auto fragmentShaderSrc = R"glsl(
+    // Same outputs as vertexShaderSrc; instance 0 is the background, 1-7 the segments and 8-11 the indicators
+    constexpr auto proceduralVertexShaderSrc = R"glsl(
+    out vec2 fragUV;
+    uniform mat4 projection;
+    uniform vec2 resolution;
+    uniform vec2 center;
+    uniform float segmentLength;
+    uniform float thickness;
+    uniform float taper;
+    uniform vec4 indicatorLayout;           // first indicator center, size, gap
+
+    // Triangle fan over the six corners of a segment; quads clamp to corner 3, leaving degenerate triangles
+    const int fan[12] = int[12](0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5);
+    // Segment centers in units of (segmentLength + thickness) / 2
+    const vec2 segmentCenter[7] = vec2[7](vec2(0, -2), vec2(1, -1), vec2(1, 1), vec2(0, 2), vec2(-1, 1), vec2(-1, -1), vec2(0, 0));
+    const vec2 square[4] = vec2[4](vec2(-1, -1), vec2(1, -1), vec2(1, 1), vec2(-1, 1));
+
+    // Corner of a horizontal segment around its center, in the order createSegment emits them
+    vec2 segmentCorner(int i)
+    {
+        float halfLength = segmentLength * 0.5;
+        if (i == 2) return vec2(halfLength, 0.0);
+        if (i == 5) return vec2(-halfLength, 0.0);
+        float x = (i == 1 || i == 3) ? halfLength - taper : -halfLength + taper;
+        return vec2(x, i < 2 ? thickness * 0.5 : -thickness * 0.5);
+    }
+
+    void main()
+    {
+        int corner = fan[gl_VertexID];
+        int element = gl_InstanceID;
+        vec2 p;
+        if (element == 0)
+        {
+            p = (square[min(corner, 3)] * 0.5 + 0.5) * resolution;
+        }
+        else if (element <= 7)
+        {
+            int segment = element - 1;
+            vec2 offset = segmentCorner(corner);
+            // Vertical segments are rotated 90 degrees counter-clockwise like rotate90CCW
+            if (segmentCenter[segment].x != 0.0) offset = vec2(-offset.y, offset.x);
+            p = center + segmentCenter[segment] * (segmentLength + thickness) * 0.5 + offset;
+        }
+        else
+        {
+            float size = indicatorLayout.z;
+            vec2 indicatorCenter = indicatorLayout.xy + vec2(float(element - 8) * (size + indicatorLayout.w), 0.0);
+            p = indicatorCenter + square[min(corner, 3)] * size * 0.5;
+        }
+        gl_Position = projection * vec4(p, 0.0, 1.0);
+        fragUV = p / resolution;
+        passElement(element);
+    }
+    )glsl";
+
+    // Shared by the element and checkerboard fragment shaders; each defines pixelFootprint() for its own pixel grid
+    constexpr auto noiseShaderSrc = R"glsl(
     #version 330 core
+// The noise needs full precision; only the palettes drop to mediump
+precision highp float;
+precision highp int;
 uniform vec2 resolution;
-in vec2 fragUV;
-in vec3 fragColor;
-out vec4 FragColor;
-
 uniform float time;
 
+vec2 pixelFootprint(vec2 p);
+
+#ifdef INTEGER_HASH
+// PCG output permutation; bit-exact on every driver
+uint pcg(uint v) {
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// p is always a lattice point, so the integer conversion is exact
+float hash(vec2 p) {
+    uvec2 q = uvec2(ivec2(p));
+    return float(pcg(q.x + pcg(q.y)) >> 8u) * (1.0 / 16777216.0);
+}
+#else
 float hash(vec2 p) {
     return fract(1e4 * sin(17.0 * p.x + p.y * 0.1) * (0.1 + abs(sin(p.y * 13.0 + p.x))));
 }
+#endif
 
 float noise(vec2 x) {
     vec2 i = floor(x);
@@ -156,32 +385,78 @@ float noise(vec2 x) {
     return mix(a, b, u.x) + (c - a) * u.y * (1.0 - u.x) + (d - b) * u.x * u.y;
 }
 
+const int maxOctaves = MAX_OCTAVES;
+
+// Octaves finer than two pixels only alias, so the loop stops there. The last octave fades out over the fractional
+// part, and skipped octaves contribute their mean so the brightness does not depend on the window size.
 float fbm(vec2 p) {
+    // Taken before the loop: derivatives are undefined under the data-dependent break
+    vec2 footprint = pixelFootprint(p);
+    float octaves = clamp(log2(0.5 / max(max(footprint.x, footprint.y), 1e-6)) / log2(1.9) + 1.0, 1.0, float(maxOctaves));
     float value = 0.0;
     float freq = 1.0;
     float amp = 0.5;
-    for (int i = 0; i < 14; ++i) {
-        value += amp * noise((p - vec2(1.0)) * freq);
+    int i = 0;
+    for (; i < maxOctaves; ++i) {
+        float weight = clamp(octaves - float(i), 0.0, 1.0);
+        if (weight <= 0.0) break;
+        value += amp * mix(0.5, noise((p - vec2(1.0)) * freq), weight);
         freq *= 1.9;
         amp *= 0.6;
     }
-    return value;
+    return value + 0.5 * amp * (1.0 - pow(0.6, float(maxOctaves - i))) / 0.4;
 }
 
 float pattern(vec2 p) {
-    vec2 aPos = vec2(sin(time/20 * 0.005), sin((time/20) * 0.01)) * 6.0;
+    vec2 aPos = vec2(sin(time/20.0 * 0.005), sin((time/20.0) * 0.01)) * 6.0;
     float a = fbm(p * vec2(3.0) + aPos);
 
-    vec2 bPos = vec2(sin((time/20) * 0.01), sin((time/20) * 0.01)) * 1.0;
+    vec2 bPos = vec2(sin((time/20.0) * 0.01), sin((time/20.0) * 0.01)) * 1.0;
     float b = fbm((p + a) * vec2(0.6) + bPos);
 
-    vec2 cPos = vec2(-0.6, -0.5) + vec2(sin(-(time/20) * 0.001), sin((time/20) * 0.01)) * 2.0;
+    vec2 cPos = vec2(-0.6, -0.5) + vec2(sin(-(time/20.0) * 0.001), sin((time/20.0) * 0.01)) * 2.0;
     float c = fbm((p + b) * vec2(2.6) + cPos);
 
     return c;
 }
 
-vec3 red_palette(float t) {
+// Each frame shades the pixels where this is 0; the palettes repeat every 1.0, so fract(pow(pattern, 2.0)) is what
+// the history stores
+int checkerParity(ivec2 pixel, int phase) {
+    return (pixel.x + pixel.y + phase) & 1;
+}
+)glsl";
+
+    constexpr auto fragmentShaderSrc = R"glsl(
+in vec2 fragUV;
+in vec3 fragColor;
+flat in vec3 fragPrevious;
+flat in float fragBlend;
+layout(location = 0) out vec4 FragColor;
+
+uniform float brightness;
+uniform int glowPass;
+
+#ifdef FLIPBOOK
+uniform mediump sampler2DArray flipbook;  // pattern() * 0.8 over one period, layer 0 at time 0
+uniform float flipbookLayers;
+uniform float flipbookPeriod;
+uniform int flipbookValid;                // 0 when the window aspect no longer matches the bake
+#endif
+
+#ifdef TEMPORAL
+layout(location = 1) out float historyOut;
+uniform sampler2D checker;               // this frame's half of the pixels, packed to half width
+uniform sampler2D history;               // the previous frame's value for every pixel
+uniform int checkerPhase;
+uniform int historyValid;                // 0 right after a resize: shade every pixel here instead
+#endif
+
+vec2 pixelFootprint(vec2 p) {
+    return fwidth(p);
+}
+
+mediump vec3 red_palette(mediump float t) {
     vec3 a = vec3(0.55, 0.0, 0.0);  // brighter dark red base
     vec3 b = vec3(0.1, 0.0, 0.0);  // smaller amplitude for less dark dips
     vec3 c = vec3(1.0, 1.0, 1.0);
@@ -189,7 +464,7 @@ vec3 red_palette(float t) {
     return a + b * cos(6.28318 * (c * t + d));
 }
 
-vec3 dark_palette(float t) {
+mediump vec3 dark_palette(mediump float t) {
     vec3 a = vec3(0.05);
     vec3 b = vec3(0.05, 0.05, 0.05);
     vec3 c = vec3(1.0, 1.0, 1.0);
@@ -197,7 +472,7 @@ vec3 dark_palette(float t) {
     return a + b * cos(6.28318 * (c * t + d));
 }
 
-vec3 light_palette(float t) {
+mediump vec3 light_palette(mediump float t) {
     vec3 a = vec3(0.24);
     vec3 b = vec3(0.1, 0.1, 0.1);
     vec3 c = vec3(1.0, 1.0, 1.0);
@@ -205,77 +480,318 @@ vec3 light_palette(float t) {
     return a + b * cos(6.28318 * (c * t + d));
 }
 
+vec3 shade(vec3 color, float val) {
+    if (color.r == 1.0 && color.g == 0.0 && color.b == 0.0) {
+        return red_palette(val);
+    } else if (color.r == 0.2 && color.g == 0.2 && color.b == 0.2) {
+        return dark_palette(val);
+    } else if (color.r == 1.0 && color.g == 1.0 && color.b == 1.0) {
+        return light_palette(val);
+    }
+    return color;
+}
+
+bool isLit(vec3 color) {
+    return color.r == 1.0 && color.g == 0.0 && color.b == 0.0;
+}
+
 void main() {
+    // Bloom source: only lit segments, following their fade
+    if (glowPass != 0) {
+        float glow = mix(isLit(fragPrevious) ? 1.0 : 0.0, isLit(fragColor) ? 1.0 : 0.0, fragBlend);
+        FragColor = vec4(vec3(1.0, 0.08, 0.04) * glow * brightness, 1.0);
+        return;
+    }
+
     vec2 uv = fragUV * 2.0 - 1.0;
     float aspect = resolution.x / resolution.y;
     uv.x *= aspect;
-    float val = pow(pattern(uv), 2.0);
-
-    if (fragColor.r == 1.0 && fragColor.g == 0.0 && fragColor.b == 0.0) {
-        FragColor = vec4(red_palette(val), 1.0);
-    } else if (fragColor.r == 0.2 && fragColor.g == 0.2 && fragColor.b == 0.2) {
-        FragColor = vec4(dark_palette(val), 1.0);
-    } else if (fragColor.r == 1.0 && fragColor.g == 1.0 && fragColor.b == 1.0) {
-        FragColor = vec4(light_palette(val), 1.0);
+#if defined(FLIPBOOK)
+    float val;
+    if (flipbookValid != 0) {
+        // Cross-fade between the two layers around the current time; rows are stored bottom up
+        float layer = mod(time, flipbookPeriod) / flipbookPeriod * flipbookLayers;
+        vec2 st = vec2(fragUV.x, 1.0 - fragUV.y);
+        float current = texture(flipbook, vec3(st, floor(layer))).r;
+        float next = texture(flipbook, vec3(st, mod(floor(layer) + 1.0, flipbookLayers))).r;
+        val = pow(mix(current, next, fract(layer)) * 1.25, 2.0);
     } else {
-        FragColor = vec4(fragColor, 1.0);
+        val = pow(pattern(uv), 2.0);
     }
+#elif defined(TEMPORAL)
+    float val;
+    if (historyValid == 0) {
+        val = pow(pattern(uv), 2.0);
+    } else {
+        ivec2 pixel = ivec2(gl_FragCoord.xy);
+        val = checkerParity(pixel, checkerPhase) == 0 ? texelFetch(checker, ivec2(pixel.x >> 1, pixel.y), 0).r
+                                                       : texelFetch(history, pixel, 0).r;
+    }
+    historyOut = fract(val);
+#else
+    float val = pow(pattern(uv), 2.0);
+#endif
+
+    vec3 color = shade(fragColor, val);
+    if (fragBlend < 1.0) color = mix(shade(fragPrevious, val), color, fragBlend);
+    FragColor = vec4(color, 1.0);
+    FragColor.rgb *= brightness;
 }
 )glsl";
 
+    // Temporal mode: the pattern for this frame's checkerboard half, one texel per shaded pixel
+    constexpr auto checkerFragmentShaderSrc = R"glsl(
+layout(location = 0) out float checkerOut;
+uniform int checkerPhase;
 
-    const GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSrc);
-    const GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSrc);
+// Texel x covers pixel 2x or 2x + 1 depending on the row, so dFdx spans two pixels and dFdy one diagonal step
+vec2 pixelFootprint(vec2 p) {
+    vec2 dx = dFdx(p) * 0.5;
+    float rowShift = checkerPhase == 0 ? 1.0 : -1.0;
+    return abs(dx) + abs(dFdy(p) - dx * rowShift);
+}
 
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 pixel = ivec2(texel.x * 2 + ((texel.y + checkerPhase) & 1), texel.y);
+    // Same UV as the element pass: fragUV runs top to bottom
+    vec2 uv = vec2(float(pixel.x) + 0.5, resolution.y - float(pixel.y) - 0.5) / resolution * 2.0 - 1.0;
+    uv.x *= resolution.x / resolution.y;
+    checkerOut = fract(pow(pattern(uv), 2.0));
+}
+)glsl";
 
-    int success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    // Flipbook bake: one layer of pattern(), scaled so its 0-1.25 range fits a unorm texel
+    constexpr auto flipbookFragmentShaderSrc = R"glsl(
+layout(location = 0) out float bakeOut;
+uniform float aspect;                    // of the window, the baked size is rounded to whole blocks
 
-    if (!success)
+vec2 pixelFootprint(vec2 p) {
+    return fwidth(p);
+}
+
+void main() {
+    vec2 uv = vec2(gl_FragCoord.x, resolution.y - gl_FragCoord.y) / resolution * 2.0 - 1.0;
+    uv.x *= aspect;
+    bakeOut = pattern(uv) * 0.8;
+}
+)glsl";
+
+    // Full-screen triangle for the checkerboard pass, the flipbook bake and the bloom chain
+    constexpr auto fullscreenVertexShaderSrc = R"glsl(
+    #version 330 core
+    out vec2 uv;
+
+    void main()
     {
-        char infoLog[1024];
-        glGetProgramInfoLog(shaderProgram, sizeof(infoLog), nullptr, infoLog);
-        cerr << "Shader Program linking failed: " << infoLog << "\n";
-        throw runtime_error("Shader Program linking failed");
+        vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+        uv = p;
+        gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
     }
+    )glsl";
+
+    // Dual-filter blur; mode 0 downsamples, 1 upsamples
+    constexpr auto bloomFragmentShaderSrc = R"glsl(
+    #version 330 core
+    precision mediump float;
+    in vec2 uv;
+    out vec4 FragColor;
 
+    uniform sampler2D source;
+    uniform vec2 halfPixel;                 // half a texel of the source level
+    uniform int mode;
+    uniform float intensity;
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    glUseProgram(shaderProgram);
+    void main()
+    {
+        vec4 sum;
+        if (mode == 0)
+        {
+            sum = texture(source, uv) * 4.0;
+            sum += texture(source, uv - halfPixel);
+            sum += texture(source, uv + halfPixel);
+            sum += texture(source, uv + vec2(halfPixel.x, -halfPixel.y));
+            sum += texture(source, uv - vec2(halfPixel.x, -halfPixel.y));
+            sum /= 8.0;
+        }
+        else
+        {
+            sum = texture(source, uv + vec2(-halfPixel.x * 2.0, 0.0));
+            sum += texture(source, uv + vec2(-halfPixel.x, halfPixel.y)) * 2.0;
+            sum += texture(source, uv + vec2(0.0, halfPixel.y * 2.0));
+            sum += texture(source, uv + vec2(halfPixel.x, halfPixel.y)) * 2.0;
+            sum += texture(source, uv + vec2(halfPixel.x * 2.0, 0.0));
+            sum += texture(source, uv + vec2(halfPixel.x, -halfPixel.y)) * 2.0;
+            sum += texture(source, uv + vec2(0.0, -halfPixel.y * 2.0));
+            sum += texture(source, uv + vec2(-halfPixel.x, -halfPixel.y)) * 2.0;
+            sum /= 12.0;
+        }
+        FragColor = vec4(sum.rgb * intensity, 1.0);
+    }
+    )glsl";
+
+    // The shaders are written against 330 core; for ES only the version line differs.
+    // Variant defines go right after it.
+    string defines;
+    auto forProfile = [&](string src)
+    {
+        constexpr string_view desktopVersion = "#version 330 core";
+        src.replace(src.find(desktopVersion), desktopVersion.size(), string(gles ? "#version 300 es" : desktopVersion) + "\n" + defines);
+        return src;
+    };
+
+    // The probe times the most expensive background: the sin hash with every octave
+    RenderSettings effective = settings;
+    if (effective.profile == QualityProfile::Auto)
+    {
+        defines = "#define MAX_OCTAVES 14\n";
+        effective.profile = probeProfile(forProfile(fullscreenVertexShaderSrc), forProfile(string(noiseShaderSrc) + flipbookFragmentShaderSrc));
+    }
+    RenderBackend::applyProfile(effective.profile, effective);
+    bloom = effective.bloom;
+    temporal = effective.temporal;
+
+    defines = "#define MAX_OCTAVES " + to_string(std::clamp(effective.maxOctaves, 1, 14)) + "\n";
+    if (effective.noise == NoiseKernel::IntegerHash) defines += "#define INTEGER_HASH\n";
+    if (temporal) defines += "#define TEMPORAL\n";
+    if (flipbookLayers) defines += "#define FLIPBOOK\n";
+
+    shaderProgram = linkProgram(forProfile(string(vertexHeaderSrc) + (geometry == Geometry::Procedural ? proceduralVertexShaderSrc : vertexShaderSrc)),
+                                forProfile(string(noiseShaderSrc) + fragmentShaderSrc));
 
     projectionLoc = glGetUniformLocation(shaderProgram, "projection");
+    timeLoc = glGetUniformLocation(shaderProgram, "time");
+    resolutionLoc = glGetUniformLocation(shaderProgram, "resolution");
+    brightnessLoc = glGetUniformLocation(shaderProgram, "brightness");
+    centerLoc = glGetUniformLocation(shaderProgram, "center");
+    segmentLengthLoc = glGetUniformLocation(shaderProgram, "segmentLength");
+    thicknessLoc = glGetUniformLocation(shaderProgram, "thickness");
+    taperLoc = glGetUniformLocation(shaderProgram, "taper");
+    indicatorLayoutLoc = glGetUniformLocation(shaderProgram, "indicatorLayout");
+    glowPassLoc = glGetUniformLocation(shaderProgram, "glowPass");
+    glUniformBlockBinding(shaderProgram, glGetUniformBlockIndex(shaderProgram, "Elements"), 0);
+
+    if (temporal)
+    {
+        checkerProgram = linkProgram(forProfile(fullscreenVertexShaderSrc), forProfile(string(noiseShaderSrc) + checkerFragmentShaderSrc));
+        checkerTimeLoc = glGetUniformLocation(checkerProgram, "time");
+        checkerResolutionLoc = glGetUniformLocation(checkerProgram, "resolution");
+        checkerPhaseLoc = glGetUniformLocation(checkerProgram, "checkerPhase");
+        elementCheckerPhaseLoc = glGetUniformLocation(shaderProgram, "checkerPhase");
+        historyValidLoc = glGetUniformLocation(shaderProgram, "historyValid");
+        glState.useProgram(shaderProgram);
+        glState.uniform1i(glGetUniformLocation(shaderProgram, "checker"), 1);
+        glState.uniform1i(glGetUniformLocation(shaderProgram, "history"), 2);
+    }
+    if (flipbookLayers)
+    {
+        flipbookValidLoc = glGetUniformLocation(shaderProgram, "flipbookValid");
+        glState.useProgram(shaderProgram);
+        glState.uniform1i(glGetUniformLocation(shaderProgram, "flipbook"), 3);
+        glState.uniform1f(glGetUniformLocation(shaderProgram, "flipbookLayers"), static_cast<float>(flipbookLayers));
+        glState.uniform1f(glGetUniformLocation(shaderProgram, "flipbookPeriod"), static_cast<float>(Flipbook::period));
+    }
 
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
+    if (bloom != BloomQuality::Off)
+    {
+        bloomProgram = linkProgram(forProfile(fullscreenVertexShaderSrc), forProfile(bloomFragmentShaderSrc));
+        bloomModeLoc = glGetUniformLocation(bloomProgram, "mode");
+        bloomHalfPixelLoc = glGetUniformLocation(bloomProgram, "halfPixel");
+        bloomIntensityLoc = glGetUniformLocation(bloomProgram, "intensity");
+        glState.useProgram(bloomProgram);
+        glState.uniform1i(glGetUniformLocation(bloomProgram, "source"), 0);
+        // ES 3.0 has no timer queries
+        if (!gles) glGenQueries(static_cast<GLsizei>(bloomQueries.size()), bloomQueries.data());
+    }
 
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    constexpr GLsizei stride = sizeof(BatchVertex);
+    if (version == GlVersion::Gl45)
+    {
+        // One immutable buffer split into ringSections, mapped once for the lifetime of the renderer
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        ringSectionSize = (sizeof(elements) + alignment - 1) / alignment * alignment;
+        const auto ringSize = static_cast<GLsizeiptr>(ringSections * ringSectionSize);
+        constexpr GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &ubo);
+        glNamedBufferStorage(ubo, ringSize, nullptr, mapFlags);
+        ringData = static_cast<uint8_t*>(glMapNamedBufferRange(ubo, 0, ringSize, mapFlags));
+        if (!ringData) throw runtime_error("Failed to map element ring buffer");
+
+        // Core profiles need a vertex array bound even when it has no attributes
+        glCreateVertexArrays(1, &vao);
+        if (geometry == Geometry::Batched)
+        {
+            glCreateBuffers(1, &vbo);
+            glCreateBuffers(1, &ebo);
+            glVertexArrayVertexBuffer(vao, 0, vbo, 0, stride);
+            glVertexArrayElementBuffer(vao, ebo);
+
+            // position (location 0), element (location 1)
+            glVertexArrayAttribFormat(vao, 0, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(BatchVertex, x));
+            glVertexArrayAttribIFormat(vao, 1, 1, GL_UNSIGNED_BYTE, offsetof(BatchVertex, element));
+            for (GLuint attrib = 0; attrib < 2; ++attrib)
+            {
+                glVertexArrayAttribBinding(vao, attrib, 0);
+                glEnableVertexArrayAttrib(vao, attrib);
+            }
+        }
+    }
+    else
+    {
+        glGenBuffers(1, &ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(elements), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
+
+        glGenVertexArrays(1, &vao);
+        if (geometry == Geometry::Batched)
+        {
+            glGenBuffers(1, &vbo);
+            glGenBuffers(1, &ebo);
 
-    constexpr GLsizei stride = 7 * sizeof(float);
+            glState.bindVertexArray(vao);
+            glState.bindArrayBuffer(vbo);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 
-    // position (location 0)
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, static_cast<void*>(nullptr));
-    glEnableVertexAttribArray(0);
+            // position (location 0)
+            glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, reinterpret_cast<void*>(offsetof(BatchVertex, x)));
+            glEnableVertexAttribArray(0);
 
-    // uv (location 1)
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+            // element (location 1)
+            glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, stride, reinterpret_cast<void*>(offsetof(BatchVertex, element)));
+            glEnableVertexAttribArray(1);
 
-    // color (location 2)
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(4 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+            glState.bindVertexArray(0);
+            glState.bindArrayBuffer(0);
+        }
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    int framebufferWidth = settings.width, framebufferHeight = settings.height;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    resize(framebufferWidth, framebufferHeight);
+    if (flipbookLayers) loadFlipbook(forProfile(fullscreenVertexShaderSrc), forProfile(string(noiseShaderSrc) + flipbookFragmentShaderSrc));
 }
 
 Renderer::~Renderer()
 {
+    for (const GLsync fence : ringFences)
+    {
+        if (fence) glDeleteSync(fence);
+    }
+    deleteBloomTargets();
+    deleteTemporalTargets();
+    glDeleteTextures(1, &flipbookTexture);
+    if (checkerProgram) glDeleteProgram(checkerProgram);
+    if (bloomProgram)
+    {
+        if (bloomQueries[0]) glDeleteQueries(static_cast<GLsizei>(bloomQueries.size()), bloomQueries.data());
+        glDeleteProgram(bloomProgram);
+    }
+    if (ringData) glUnmapNamedBuffer(ubo);
+    glDeleteBuffers(1, &ubo);
+    glDeleteBuffers(1, &ebo);
     glDeleteBuffers(1, &vbo);
     glDeleteVertexArrays(1, &vao);
     glDeleteProgram(shaderProgram);
@@ -284,108 +800,712 @@ Renderer::~Renderer()
     glfwTerminate();
 }
 
-void Renderer::drawFrame(const array<Segment, 7>& segments, const vector<vector<vec2>>& bitSquares) const
+void Renderer::resize(const int width, const int height)
 {
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glState.viewport(0, 0, width, height);
+    screenSize = vec2(width, height);
+    projection = ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f);
+    glState.useProgram(shaderProgram);
+    glState.uniformMatrix4fv(projectionLoc, value_ptr(projection));
+    // Runs inside the GLFW callback, so a failure turns the effect off instead of throwing through C frames
+    if (bloom != BloomQuality::Off && !createBloomTargets())
+    {
+        cerr << "Bloom framebuffer incomplete at " << width << "x" << height << ", bloom disabled" << endl;
+        bloom = BloomQuality::Off;
+    }
+    if (temporal && (width == 0 || height == 0))
+    {
+        // A minimized window has no pixels to keep history for; the targets return with the next real size
+        deleteTemporalTargets();
+        historyValid = false;
+        glState.uniform1i(historyValidLoc, 0);
+    }
+    else if (temporal && !createTemporalTargets())
+    {
+        cerr << "Checkerboard framebuffers incomplete at " << width << "x" << height << ", temporal shading disabled" << endl;
+        temporal = false;
+        // The shader then shades every pixel itself
+        glState.uniform1i(historyValidLoc, 0);
+    }
+    if (flipbookTexture) glState.uniform1i(flipbookValidLoc, abs(screenSize.x / screenSize.y - flipbookAspect) < 0.01f * flipbookAspect);
+}
+
+void Renderer::deleteBloomTargets()
+{
+    glDeleteFramebuffers(static_cast<GLsizei>(bloomFramebuffers.size()), bloomFramebuffers.data());
+    glDeleteTextures(static_cast<GLsizei>(bloomTextures.size()), bloomTextures.data());
+    bloomFramebuffers.clear();
+    bloomTextures.clear();
+    bloomSizes.clear();
+}
+
+bool Renderer::createBloomTargets()
+{
+    deleteBloomTargets();
+
+    const int firstShift = bloom == BloomQuality::Low ? 2 : 1;
+    const int levels = bloom == BloomQuality::High ? 4 : bloom == BloomQuality::Medium ? 3 : 2;
+    for (int level = 0; level < levels; ++level)
+    {
+        const int shift = firstShift + level;
+        bloomSizes.emplace_back(max(1, static_cast<int>(screenSize.x) >> shift), max(1, static_cast<int>(screenSize.y) >> shift));
+    }
+
+    bloomTextures.resize(levels);
+    bloomFramebuffers.resize(levels);
+    glGenTextures(levels, bloomTextures.data());
+    glGenFramebuffers(levels, bloomFramebuffers.data());
+    bool complete = true;
+    for (int level = 0; level < levels && complete; ++level)
+    {
+        glBindTexture(GL_TEXTURE_2D, bloomTextures[level]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, bloomSizes[level].x, bloomSizes[level].y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, bloomFramebuffers[level]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bloomTextures[level], 0);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) deleteBloomTargets();
+    return complete;
+}
+
+void Renderer::drawBloom()
+{
+    // Collect the measurement of the frame that used this query last time
+    const GLuint query = bloomQueries[bloomQueriesIssued % bloomQueries.size()];
+    if (query && bloomQueriesIssued >= bloomQueries.size())
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            bloomNanoseconds += nanoseconds;
+            bloomSamples++;
+        }
+    }
+    if (query) glBeginQuery(GL_TIME_ELAPSED, query);
+    bloomQueriesIssued++;
+
+    // Extract the lit segments by drawing the scene again with the glow mask
+    glBindFramebuffer(GL_FRAMEBUFFER, bloomFramebuffers[0]);
+    glState.viewport(0, 0, bloomSizes[0].x, bloomSizes[0].y);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glState.uniform1i(glowPassLoc, 1);
+    drawElements();
+    glState.uniform1i(glowPassLoc, 0);
+
+    glState.useProgram(bloomProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glState.uniform1f(bloomIntensityLoc, 1.0f);
+    auto pass = [&](const size_t from, const int mode)
+    {
+        glBindTexture(GL_TEXTURE_2D, bloomTextures[from]);
+        glState.uniform2f(bloomHalfPixelLoc, 0.5f / bloomSizes[from].x, 0.5f / bloomSizes[from].y);
+        glState.uniform1i(bloomModeLoc, mode);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    };
+
+    const size_t levels = bloomTextures.size();
+    for (size_t level = 1; level < levels; ++level)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, bloomFramebuffers[level]);
+        glState.viewport(0, 0, bloomSizes[level].x, bloomSizes[level].y);
+        pass(level - 1, 0);
+    }
+    for (size_t level = levels - 1; level > 0; --level)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, bloomFramebuffers[level - 1]);
+        glState.viewport(0, 0, bloomSizes[level - 1].x, bloomSizes[level - 1].y);
+        pass(level, 1);
+    }
+
+    // Last upsample goes straight onto the frame, added to it
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState.viewport(0, 0, static_cast<GLsizei>(screenSize.x), static_cast<GLsizei>(screenSize.y));
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glState.uniform1f(bloomIntensityLoc, 0.35f);
+    pass(0, 1);
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (query) glEndQuery(GL_TIME_ELAPSED);
+}
 
-    glUseProgram(shaderProgram);
-    glBindVertexArray(vao);
+void Renderer::deleteTemporalTargets()
+{
+    glDeleteFramebuffers(1, &checkerFramebuffer);
+    glDeleteFramebuffers(static_cast<GLsizei>(historyFramebuffers.size()), historyFramebuffers.data());
+    glDeleteTextures(1, &checkerTexture);
+    glDeleteTextures(1, &sceneTexture);
+    glDeleteTextures(static_cast<GLsizei>(historyTextures.size()), historyTextures.data());
+    checkerFramebuffer = checkerTexture = sceneTexture = 0;
+    historyFramebuffers = {};
+    historyTextures = {};
+}
 
-    glUniform1f(glGetUniformLocation(shaderProgram, "time"), Main::getFrame());
-    glUniform2f(glGetUniformLocation(shaderProgram, "resolution"), screenSize.x, screenSize.y);
+bool Renderer::createTemporalTargets()
+{
+    deleteTemporalTargets();
 
-    // Draw background
-    constexpr auto bgColor = vec3(0.2f);
-    const vector<float> bgVertices = {
-        0, 0, 0, 0, bgColor.r, bgColor.g, bgColor.b,
-        screenSize.x, 0, 1, 0, bgColor.r, bgColor.g, bgColor.b,
-        screenSize.x, screenSize.y, 1, 1, bgColor.r, bgColor.g, bgColor.b,
-        0, screenSize.y, 0, 1, bgColor.r, bgColor.g, bgColor.b
+    const auto width = static_cast<GLsizei>(screenSize.x);
+    const auto height = static_cast<GLsizei>(screenSize.y);
+    // Only read with texelFetch, but the filter must not need mipmaps for the texture to be complete
+    auto createTexture = [](const GLenum internalFormat, const GLenum format, const GLsizei w, const GLsizei h)
+    {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(internalFormat), w, h, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        return texture;
     };
+    checkerTexture = createTexture(GL_R8, GL_RED, (width + 1) / 2, height);
+    sceneTexture = createTexture(GL_RGBA8, GL_RGBA, width, height);
+    for (GLuint& texture : historyTextures) texture = createTexture(GL_R8, GL_RED, width, height);
+
+    glGenFramebuffers(1, &checkerFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, checkerFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, checkerTexture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    glGenFramebuffers(static_cast<GLsizei>(historyFramebuffers.size()), historyFramebuffers.data());
+    constexpr GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    for (size_t i = 0; i < historyFramebuffers.size() && complete; ++i)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, historyFramebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, historyTextures[i], 0);
+        glDrawBuffers(2, drawBuffers);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) deleteTemporalTargets();
+
+    // The old history no longer lines up with the pixels, so the next frame shades everything
+    historyValid = false;
+    return complete;
+}
+
+void Renderer::drawCheckerboard(const Scene& scene)
+{
+    const auto width = static_cast<GLsizei>(screenSize.x);
+    const auto height = static_cast<GLsizei>(screenSize.y);
+    if (historyValid)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, checkerFramebuffer);
+        glState.viewport(0, 0, (width + 1) / 2, height);
+        glState.useProgram(checkerProgram);
+        glState.uniform1f(checkerTimeLoc, scene.time);
+        glState.uniform2f(checkerResolutionLoc, screenSize.x, screenSize.y);
+        glState.uniform1i(checkerPhaseLoc, checkerPhase);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glState.viewport(0, 0, width, height);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, historyFramebuffers[historyIndex]);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, checkerTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, historyTextures[historyIndex ^ 1]);
+    glActiveTexture(GL_TEXTURE0);
+    glState.useProgram(shaderProgram);
+    glState.uniform1i(elementCheckerPhaseLoc, checkerPhase);
+    glState.uniform1i(historyValidLoc, historyValid ? 1 : 0);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 static_cast<GLsizeiptr>(bgVertices.size() * sizeof(float)),
-                 bgVertices.data(),
-                 GL_DYNAMIC_DRAW);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, static_cast<GLsizei>(bgVertices.size() / 7));
+void Renderer::resolveTemporal()
+{
+    const auto width = static_cast<GLsizei>(screenSize.x);
+    const auto height = static_cast<GLsizei>(screenSize.y);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, historyFramebuffers[historyIndex]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // This frame's values become the history; the other half of the pixels is shaded next
+    historyIndex ^= 1;
+    checkerPhase ^= 1;
+    historyValid = true;
+}
 
-    // Draw segments
-    for (const auto& [points, color] : segments)
+QualityProfile Renderer::probeProfile(const string& vertexSrc, const string& fragmentSrc)
+{
+    const string rendererName = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    const string versionName = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+
+    // A CPU rasterizer shares its cores with everything else, so it never gets the multipass profiles
+    bool software = false;
+    for (const char* rasterizer : {"llvmpipe", "softpipe", "SwiftShader", "Software Rasterizer"})
+    {
+        software |= rendererName.find(rasterizer) != string::npos;
+    }
+
+    // One file per machine and driver, so a driver update probes again. It holds the cost per megapixel, and the
+    // profile is picked from that at every start's window size.
+    char name[64];
+    snprintf(name, sizeof(name), "profile-%016llx", static_cast<unsigned long long>(Flipbook::hash(string(host) + "\n" + rendererName + "\n" + versionName)));
+    const string path = (filesystem::path(RenderBackend::getCacheDirectory()) / name).string();
+    double megapixelMs = 0;
+    if (ifstream in(path); in)
+    {
+        for (string line; getline(in, line);)
+        {
+            if (line.starts_with("megapixelMs=")) from_chars(line.data() + 12, line.data() + line.size(), megapixelMs);
+        }
+    }
+    // A missing or unreadable entry is a cache miss
+    const bool cached = isfinite(megapixelMs) && megapixelMs > 0;
+    if (!cached)
     {
-        vector<float> vertices;
-        // For each point, add x,y then r,g,b
-        for (const vec2& p : points)
+        // GPU time where the driver can measure it, wall-clock time around glFinish otherwise. llvmpipe's timer
+        // queries only cover part of its threaded rasterization, so CPU rasterizers always use the wall clock.
+        const bool timerQuery = !software && (version != GlVersion::Gles30 || hasGlExtension("GL_EXT_disjoint_timer_query"));
+        megapixelMs = measureBackground(vertexSrc, fragmentSrc, timerQuery);
+        cerr << "Probed " << rendererName << ": " << megapixelMs << " ms per megapixel (" << (timerQuery ? "GPU timer" : "wall clock") << ")\n";
+
+        // Without a writable cache the probe simply runs again next time
+        if (error_code error; filesystem::create_directories(RenderBackend::getCacheDirectory(), error) || !error)
         {
-            vec2 uv = vec2(p.x / screenSize.x, p.y / screenSize.y);
-
-            vertices.push_back(p.x);
-            vertices.push_back(p.y);
-            vertices.push_back(uv.x);
-            vertices.push_back(uv.y);
-            vertices.push_back(color.r);
-            vertices.push_back(color.g);
-            vertices.push_back(color.b);
+            if (ofstream out(path); out)
+            {
+                out << "renderer=" << rendererName << "\nversion=" << versionName << "\nmegapixelMs=" << megapixelMs << "\n";
+            }
         }
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER,
-                     static_cast<GLsizeiptr>(vertices.size() * sizeof(float)),
-                     vertices.data(),
-                     GL_DYNAMIC_DRAW);
+    // Background cost of one full frame at the current size, against a 60 Hz budget
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    const double frameMs = megapixelMs * width * height / 1e6;
+    QualityProfile profile = frameMs < 4 ? QualityProfile::High : frameMs < 10 ? QualityProfile::Medium
+                           : frameMs < 30 ? QualityProfile::Low : QualityProfile::Minimal;
+    if (software && profile > QualityProfile::Low) profile = QualityProfile::Low;
+
+    cerr << "Quality profile " << RenderBackend::getProfileName(profile) << " at " << width << "x" << height << " ("
+         << (cached ? "cached in " + path : "probed") << ")\n";
+    return profile;
+}
+
+double Renderer::measureBackground(const string& vertexSrc, const string& fragmentSrc, const bool timerQuery)
+{
+    // Window-sized coordinates over a fixed corner, so each pixel runs as many octaves as in a real frame
+    constexpr int probeSize = 256;
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    const GLuint program = linkProgram(vertexSrc, fragmentSrc);
+    glState.useProgram(program);
+    glState.uniform2f(glGetUniformLocation(program, "resolution"), static_cast<float>(width), static_cast<float>(height));
+    glState.uniform1f(glGetUniformLocation(program, "aspect"), static_cast<float>(width) / static_cast<float>(max(height, 1)));
+    glState.uniform1f(glGetUniformLocation(program, "time"), 0.0f);
+
+    GLuint texture = 0, framebuffer = 0, probeVao = 0, query = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, probeSize, probeSize, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glState.viewport(0, 0, probeSize, probeSize);
+    glGenVertexArrays(1, &probeVao);
+    glState.bindVertexArray(probeVao);
+    if (timerQuery) glGenQueries(1, &query);
+
+    // The first draw includes the driver's deferred shader compilation and is not counted
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glFinish();
+    int draws = 0;
+    double seconds = 0;
+    const auto start = chrono::steady_clock::now();
+    while (draws < 32 && chrono::duration<double>(chrono::steady_clock::now() - start).count() < 0.25)
+    {
+        if (query) glBeginQuery(GL_TIME_ELAPSED, query);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        if (query)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            seconds += nanoseconds / 1e9;
+        }
+        glFinish();
+        draws++;
+    }
+    if (!query) seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (query) glDeleteQueries(1, &query);
+    glState.forgetVertexArray(probeVao);
+    glDeleteVertexArrays(1, &probeVao);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+    glState.forgetProgram(program);
+    glDeleteProgram(program);
+
+    return seconds * 1e3 / draws / (probeSize * probeSize / 1e6);
+}
 
-        glDrawArrays(GL_TRIANGLE_FAN, 0, static_cast<GLsizei>(vertices.size() / 7));
+void Renderer::loadFlipbook(const string& vertexSrc, const string& fragmentSrc)
+{
+    // Half the window resolution in whole BC4 blocks; bilinear filtering covers the upscale
+    const int width = max(4, static_cast<int>(screenSize.x) / 8 * 4);
+    const int height = max(4, static_cast<int>(screenSize.y) / 8 * 4);
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (flipbookLayers > maxLayers)
+    {
+        throw runtime_error("The driver supports at most " + to_string(maxLayers) + " array texture layers, too few for a " +
+                            to_string(flipbookLayers) + "-layer flipbook; run without --flipbook");
     }
-    // Draw bit Indicators
-    for (int i = 0; i < 4; ++i)
+    const uint64_t shaderHash = Flipbook::hash(fragmentSrc);
+    const string path = Flipbook::cachePath(width, height, flipbookLayers, shaderHash);
+    if (!filesystem::exists(path)) bakeFlipbook(vertexSrc, fragmentSrc, width, height, path, shaderHash);
+    const Flipbook flipbook(path, width, height, flipbookLayers, shaderHash);
+
+    glGenTextures(1, &flipbookTexture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, flipbookTexture);
+    if (version == GlVersion::Gles30)
     {
-        const int bitIndex = 3 - i;
-        const uint8_t inputBits = Main::getBits();
-        const bool isOn = (inputBits >> bitIndex) & 1;
-        const vec3 color = isOn ? vec3(1.0f, 0.0f, 0.0f) : vec3(1.0f);
+        // ES 3.0 has no RGTC, so the layers are expanded to R8 on upload
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, width, height, flipbookLayers, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        vector<uint8_t> pixels(static_cast<size_t>(width) * height);
+        const size_t layerBytes = Flipbook::layerBytes(width, height);
+        for (int layer = 0; layer < flipbookLayers; ++layer)
+        {
+            Flipbook::decompressLayer(flipbook.getBlocks() + layerBytes * layer, width, height, pixels.data());
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+        }
+    }
+    else
+    {
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_COMPRESSED_RED_RGTC1, width, height, flipbookLayers, 0,
+                               static_cast<GLsizei>(flipbook.getSize()), flipbook.getBlocks());
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glActiveTexture(GL_TEXTURE0);
+
+    flipbookAspect = screenSize.x / screenSize.y;
+    glState.useProgram(shaderProgram);
+    glState.uniform1i(flipbookValidLoc, 1);
+}
 
-        vector<float> vertices;
-        // Add position and color per vertex
-        for (const vec2& p : bitSquares[i])
+void Renderer::bakeFlipbook(const string& vertexSrc, const string& fragmentSrc, const int width, const int height, const string& path,
+                            const uint64_t shaderHash)
+{
+    cerr << "Baking " << flipbookLayers << " flipbook layers at " << width << "x" << height << " into " << path << "\n";
+    const auto start = chrono::steady_clock::now();
+
+    const GLuint program = linkProgram(vertexSrc, fragmentSrc);
+    glState.useProgram(program);
+    glState.uniform2f(glGetUniformLocation(program, "resolution"), static_cast<float>(width), static_cast<float>(height));
+    glState.uniform1f(glGetUniformLocation(program, "aspect"), screenSize.x / screenSize.y);
+    const GLint bakeTimeLoc = glGetUniformLocation(program, "time");
+
+    GLuint texture = 0, framebuffer = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        throw runtime_error("Flipbook framebuffer incomplete");
+    }
+    glState.viewport(0, 0, width, height);
+    glState.bindVertexArray(vao);
+
+    // The GPU renders the next layer while worker threads compress the ones already read back
+    const size_t layerBytes = Flipbook::layerBytes(width, height);
+    const size_t layerPixels = static_cast<size_t>(width) * height;
+    vector<uint8_t> blocks(layerBytes * flipbookLayers);
+    vector<double> layerErrors(flipbookLayers);
+    const size_t workers = max(1u, thread::hardware_concurrency());
+    deque<future<void>> pending;
+    for (int layer = 0; layer < flipbookLayers; ++layer)
+    {
+        glState.uniform1f(bakeTimeLoc, static_cast<float>(Flipbook::period * layer / flipbookLayers));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        // RGBA is the one read format ES guarantees
+        vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        if (pending.size() >= workers)
+        {
+            pending.front().get();
+            pending.pop_front();
+        }
+        pending.push_back(async(launch::async, [&blocks, &layerErrors, layerBytes, layerPixels, width, height, layer, pixels = std::move(pixels)]() mutable
+        {
+            for (size_t i = 0; i < layerPixels; ++i) pixels[i] = pixels[i * 4];
+            uint8_t* layerBlocks = blocks.data() + layerBytes * layer;
+            Flipbook::compressLayer(pixels.data(), width, height, layerBlocks);
+            layerErrors[layer] = Flipbook::checkRoundTrip(pixels.data(), layerBlocks, width, height);
+        }));
+    }
+    for (future<void>& job : pending) job.get();
+
+    // The cross-fade is only exact at layer times; compare it with the live pattern halfway between a few layer pairs
+    const int midSamples = min(flipbookLayers, 4);
+    double midError = 0;
+    vector<uint8_t> live(layerPixels * 4), current(layerPixels), next(layerPixels);
+    for (int sample = 0; sample < midSamples; ++sample)
+    {
+        const int layer = sample * flipbookLayers / midSamples;
+        glState.uniform1f(bakeTimeLoc, static_cast<float>(Flipbook::period * (layer + 0.5) / flipbookLayers));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, live.data());
+        Flipbook::decompressLayer(blocks.data() + layerBytes * layer, width, height, current.data());
+        Flipbook::decompressLayer(blocks.data() + layerBytes * ((layer + 1) % flipbookLayers), width, height, next.data());
+        for (size_t i = 0; i < layerPixels; ++i)
         {
-            vec2 uv = vec2(p.x / screenSize.x, p.y / screenSize.y);
-
-            vertices.push_back(p.x);
-            vertices.push_back(p.y);
-            vertices.push_back(uv.x);
-            vertices.push_back(uv.y);
-            vertices.push_back(color.r);
-            vertices.push_back(color.g);
-            vertices.push_back(color.b);
+            const double error = (current[i] + next[i]) / 2.0 - live[i * 4];
+            midError += error * error;
         }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState.viewport(0, 0, static_cast<GLsizei>(screenSize.x), static_cast<GLsizei>(screenSize.y));
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+    glState.forgetProgram(program);
+    glDeleteProgram(program);
+
+    Flipbook::write(path, width, height, flipbookLayers, shaderHash, blocks);
+    double layerError = 0;
+    for (const double error : layerErrors) layerError += error;
+    auto psnr = [](const double squaredError, const double count) { return 10 * log10(255.0 * 255.0 * count / max(squaredError, 1e-9)); };
+    cerr << "Baked " << blocks.size() / 1e6 << " MB in " << chrono::duration<double>(chrono::steady_clock::now() - start).count()
+         << " s, PSNR " << psnr(layerError, static_cast<double>(layerPixels) * flipbookLayers) << " dB at layer times, "
+         << psnr(midError, static_cast<double>(layerPixels) * midSamples) << " dB halfway between layers\n";
+}
 
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER,
-                     static_cast<GLsizeiptr>(vertices.size() * sizeof(float)),
-                     vertices.data(),
-                     GL_DYNAMIC_DRAW);
+void Renderer::drawElements() const
+{
+    if (geometry == Geometry::Procedural)
+    {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 12, 12);
+    }
+    else
+    {
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, nullptr);
+    }
+}
+
+void Renderer::addFan(const span<const vec2> points, const uint8_t element)
+{
+    const auto base = static_cast<uint16_t>(batchVertices.size());
+    auto quantize = [](const float v) { return static_cast<uint16_t>(lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f)); };
+    for (const vec2& p : points)
+    {
+        batchVertices.push_back({quantize(p.x / screenSize.x), quantize(p.y / screenSize.y), element, {}});
+    }
+    for (size_t i = 1; i + 1 < points.size(); ++i)
+    {
+        batchIndices.insert(batchIndices.end(), {base, static_cast<uint16_t>(base + i), static_cast<uint16_t>(base + i + 1)});
+    }
+}
 
-        glDrawArrays(GL_TRIANGLE_FAN, 0, static_cast<GLsizei>(vertices.size() / 7));
+void Renderer::buildGeometry(const Scene& scene)
+{
+    batchVertices.clear();
+    batchIndices.clear();
+
+    // Element 0 is the background, then the segments, then the indicators
+    const vec2 background[] = {vec2(0), vec2(screenSize.x, 0), screenSize, vec2(0, screenSize.y)};
+    uint8_t element = 0;
+    addFan(background, element++);
+    for (const auto& segment : scene.segments) addFan(segment.points, element++);
+    for (const auto& indicator : scene.indicators) addFan(indicator.points, element++);
+
+    const auto vertexSize = static_cast<GLsizeiptr>(batchVertices.size() * sizeof(BatchVertex));
+    const auto indexSize = static_cast<GLsizeiptr>(batchIndices.size() * sizeof(uint16_t));
+    if (version == GlVersion::Gl45)
+    {
+        glNamedBufferData(vbo, vertexSize, batchVertices.data(), GL_STATIC_DRAW);
+        glNamedBufferData(ebo, indexSize, batchIndices.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        glState.bindVertexArray(vao);
+        glState.bindArrayBuffer(vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertexSize, batchVertices.data(), GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize, batchIndices.data(), GL_STATIC_DRAW);
     }
-    glBindVertexArray(0);
+    indexCount = static_cast<GLsizei>(batchIndices.size());
+    geometrySize = scene.screenSize;
+}
+
+void Renderer::setLayoutUniforms()
+{
+    const GlyphLayout layout = calculateLayout(screenSize);
+    glState.useProgram(shaderProgram);
+    glState.uniform2f(centerLoc, layout.center.x, layout.center.y);
+    glState.uniform1f(segmentLengthLoc, layout.segmentLength);
+    glState.uniform1f(thicknessLoc, layout.thickness);
+    glState.uniform1f(taperLoc, layout.taper);
+    glState.uniform4f(indicatorLayoutLoc, layout.indicatorOrigin.x, layout.indicatorOrigin.y, layout.indicatorSize, layout.indicatorGap);
+    geometrySize = screenSize;
+}
+
+bool Renderer::updateElements(const Scene& scene)
+{
+    array<vec3, elementCount> colors;
+    colors[0] = vec3(0.2f);
+    for (size_t i = 0; i < scene.segments.size(); ++i) colors[1 + i] = scene.segments[i].color;
+    for (size_t i = 0; i < scene.indicators.size(); ++i) colors[8 + i] = scene.indicators[i].color;
 
-    if (Main::getFrame() == 1) resizeCallback(window, screenSize.x, screenSize.y);
+    bool changed = false;
+    for (size_t i = 0; i < elementCount; ++i)
+    {
+        auto& [color, previous] = elements[i];
+        const vec3 current = vec3(color.r, color.g, color.b);
+        if (elementsValid && current == colors[i]) continue;
+
+        // The fade starts from the last target even if the previous fade has not finished
+        const float duration = colors[i] == vec3(1.0f, 0.0f, 0.0f) ? fadeInFrames : afterglowFrames;
+        previous = vec4(elementsValid ? current : colors[i], duration);
+        color = vec4(colors[i], elementsValid ? scene.time : -duration);
+        changed = true;
+    }
+    elementsValid = true;
+    return changed;
 }
 
+void Renderer::drawFrame(const Scene& scene)
+{
+    // Scene geometry only depends on the screen size, so it is updated only after a resize
+    if (geometry == Geometry::Procedural)
+    {
+        if (screenSize != geometrySize) setLayoutUniforms();
+    }
+    else if (scene.screenSize != geometrySize || indexCount == 0)
+    {
+        buildGeometry(scene);
+    }
+
+    if (updateElements(scene))
+    {
+        if (ringData)
+        {
+            // Sections are only switched on a change; the fence covers every draw that read the old one
+            ringFences[ringSection] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            ringSection = (ringSection + 1) % ringSections;
+            // The mapping is coherent, so the only hazard is overwriting a section the GPU still reads from
+            if (const GLsync fence = ringFences[ringSection])
+            {
+                while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+                {
+                }
+                glDeleteSync(fence);
+                ringFences[ringSection] = nullptr;
+            }
+            const size_t offset = ringSection * ringSectionSize;
+            memcpy(ringData + offset, elements.data(), sizeof(elements));
+            glBindBufferRange(GL_UNIFORM_BUFFER, 0, ubo, static_cast<GLintptr>(offset), sizeof(elements));
+        }
+        else
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(elements), elements.data());
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+    }
+
+    glState.bindVertexArray(vao);
+    const bool checkerboard = temporal && checkerFramebuffer;
+    if (checkerboard) drawCheckerboard(scene);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glState.useProgram(shaderProgram);
+
+    glState.uniform1f(timeLoc, scene.time);
+    glState.uniform2f(resolutionLoc, screenSize.x, screenSize.y);
+    glState.uniform1f(brightnessLoc, scene.brightness);
+
+    // Background, segments and indicators in a single draw
+    drawElements();
+    if (checkerboard) resolveTemporal();
+    if (bloom != BloomQuality::Off) drawBloom();
+}
+
+void Renderer::present()
+{
+    glfwSwapBuffers(window);
+    glFinish();
+    if (GlProfiler::isInstalled()) GlProfiler::endFrame();
+    if (GlCapture::isInstalled()) GlCapture::endFrame();
+}
+
+void Renderer::pollEvents()
+{
+    glfwPollEvents();
+}
+
+bool Renderer::isOpen() const
+{
+    return !glfwWindowShouldClose(window);
+}
+
+vec2 Renderer::getScreenSize() const
+{
+    return screenSize;
+}
+
+const char* Renderer::getName() const
+{
+    if (geometry == Geometry::Procedural) return "procedural";
+    if (version == GlVersion::Gles30) return "gles30";
+    return version == GlVersion::Gl45 ? "gl45" : "gl33";
+}
+
+bool Renderer::hasGlContext() const
+{
+    return true;
+}
+
+bool Renderer::needsGeometry() const
+{
+    return geometry == Geometry::Batched;
+}
 
 GLFWwindow* Renderer::getWindow() const
 {
     return window;
 }
 
-vec2 Renderer::getScreenSize()
+vector<uint8_t> Renderer::readPixels() const
 {
-    return screenSize;
+    vector<uint8_t> pixels(static_cast<size_t>(screenSize.x) * static_cast<size_t>(screenSize.y) * 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glReadPixels(0, 0, static_cast<GLsizei>(screenSize.x), static_cast<GLsizei>(screenSize.y), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+double Renderer::getBloomMs() const
+{
+    return bloomSamples ? bloomNanoseconds / 1e6 / bloomSamples : 0;
 }
 
-void Renderer::setScreenSize(const vec2 newScreenSize)
+const GlStateCache& Renderer::getStateCache() const
 {
-    screenSize.x = newScreenSize.x;
-    screenSize.y = newScreenSize.y;
+    return glState;
 }
@@ -0,0 +1,146 @@
+#include "sevensegmentdisplay/Scene.hpp"
+#include "sevensegmentdisplay/Main.hpp"
+
+using namespace std;
+using namespace glm;
+
+vector<vec2> createSegment(const float cx, const float cy, const float length, const float thickness, const float taper)
+{
+    return {
+        {cx - length / 2 + taper, cy + thickness / 2},
+        {cx + length / 2 - taper, cy + thickness / 2},
+        {cx + length / 2, cy},
+        {cx + length / 2 - taper, cy - thickness / 2},
+        {cx - length / 2 + taper, cy - thickness / 2},
+        {cx - length / 2, cy}
+    };
+}
+
+vector<vec2> rotate90CCW(const vector<vec2>& points, const float cx, const float cy)
+{
+    vector<vec2> rotated;
+    for (auto& p : points)
+    {
+        const float dx = p.x - cx;
+        const float dy = p.y - cy;
+        rotated.emplace_back(cx - dy, cy + dx);
+    }
+    return rotated;
+}
+
+vector<vec2> createSquare(const float cx, const float cy, const float size)
+{
+    const float half = size / 2.0f;
+    return {
+            {cx - half, cy - half},
+            {cx + half, cy - half},
+            {cx + half, cy + half},
+            {cx - half, cy + half}
+    };
+}
+
+GlyphLayout calculateLayout(const vec2 screenSize)
+{
+    GlyphLayout layout;
+    const float yOffset = screenSize.y * -0.07;
+    layout.center = vec2(screenSize.x / 2.0f, screenSize.y / 2.0f + yOffset);
+
+    layout.segmentLength = screenSize.y * 0.25f;
+    layout.thickness = screenSize.y * 0.06f;
+    layout.taper = 0;
+
+    layout.indicatorSize = screenSize.y * 0.06f;
+    layout.indicatorGap = screenSize.x * 0.01f;
+
+    const float totalWidth = layout.indicatorSize * 4 + layout.indicatorGap * 3;
+    layout.indicatorOrigin = vec2(layout.center.x - totalWidth / 2 + layout.indicatorSize / 2,
+                                  layout.center.y + layout.segmentLength + layout.thickness * 3.0f + 20.0f);
+    return layout;
+}
+
+static void applySegmentColors(array<Segment, 7>& segments, const uint8_t segmentValue)
+{
+    const uint8_t segBits = Main::applySegmentOverride(digitToSegments[segmentValue & 0xF]);
+    for (int i = 0; i < 7; ++i)
+    {
+        const bool isOn = (segBits >> i) & 1;
+        segments[i].color = isOn ? vec3(1.0f, 0.0f, 0.0f) : vec3(1.0f);
+    }
+}
+
+array<Segment, 7> calculateSegments(const vec2 screenSize, const uint8_t segmentValue)
+{
+    array<Segment, 7> segments;
+    const GlyphLayout layout = calculateLayout(screenSize);
+    const float centerX = layout.center.x;
+    const float centerY = layout.center.y;
+    const float segmentLength = layout.segmentLength;
+    const float thickness = layout.thickness;
+    const float taper = layout.taper;
+
+    const float verticalX = segmentLength / 2 + thickness / 2;
+    const float upperVerticalY = centerY - segmentLength / 2 - thickness / 2;
+    const float lowerVerticalY = centerY + segmentLength / 2 + thickness / 2;
+
+    segments[0].points = createSegment(centerX, centerY - segmentLength - thickness, segmentLength, thickness, taper);
+    segments[3].points = createSegment(centerX, centerY + segmentLength + thickness, segmentLength, thickness, taper);
+    segments[6].points = createSegment(centerX, centerY, segmentLength, thickness, taper);
+
+
+    segments[1].points = rotate90CCW(
+        createSegment(centerX + verticalX, upperVerticalY, segmentLength, thickness, taper),
+        centerX + verticalX, upperVerticalY);
+    segments[2].points = rotate90CCW(
+        createSegment(centerX + verticalX, lowerVerticalY, segmentLength, thickness, taper),
+        centerX + verticalX, lowerVerticalY);
+    segments[4].points = rotate90CCW(
+        createSegment(centerX - verticalX, lowerVerticalY, segmentLength, thickness, taper),
+        centerX - verticalX, lowerVerticalY);
+    segments[5].points = rotate90CCW(
+        createSegment(centerX - verticalX, upperVerticalY, segmentLength, thickness, taper),
+        centerX - verticalX, upperVerticalY);
+
+    applySegmentColors(segments, segmentValue);
+    return segments;
+}
+
+vector<vector<vec2>> calculateBitIndicators(const vec2 screenSize)
+{
+    const GlyphLayout layout = calculateLayout(screenSize);
+
+    vector<vector<vec2>>  bitIndicators(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        const float x = layout.indicatorOrigin.x + i * (layout.indicatorSize + layout.indicatorGap);
+        bitIndicators[i] = createSquare(x, layout.indicatorOrigin.y, layout.indicatorSize);
+    }
+    return bitIndicators;
+}
+
+Scene buildScene(const vec2 screenSize, const bool geometry)
+{
+    Scene scene;
+    scene.digit = Main::getBits();
+    if (geometry)
+    {
+        scene.segments = calculateSegments(screenSize, scene.digit);
+        const vector<vector<vec2>> bitSquares = calculateBitIndicators(screenSize);
+        for (int i = 0; i < 4; ++i) scene.indicators[i].points = bitSquares[i];
+    }
+    else
+    {
+        applySegmentColors(scene.segments, scene.digit);
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const int bitIndex = 3 - i;
+        const bool isOn = (scene.digit >> bitIndex) & 1;
+        scene.indicators[i].color = isOn ? vec3(1.0f, 0.0f, 0.0f) : vec3(1.0f);
+    }
+
+    scene.screenSize = screenSize;
+    scene.time = Main::getFrame();
+    scene.brightness = Main::getBrightness();
+    return scene;
+}
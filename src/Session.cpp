@@ -0,0 +1,212 @@
+#include "sevensegmentdisplay/Session.hpp"
+#include "sevensegmentdisplay/InputQueue.hpp"
+#include "sevensegmentdisplay/Renderer.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+static constexpr char magic[8] = {'S', 'S', 'D', 'R', 'E', 'C', '1', '\n'};
+static constexpr size_t flushThreshold = 64 * 1024;
+
+vector<uint8_t> Session::buffer;
+int Session::fd = -1;
+uint64_t Session::lastTimestamp = 0;
+
+static uint64_t zigzag(const int64_t value)
+{
+    return static_cast<uint64_t>(value) << 1 ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t unzigzag(const uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static uint64_t nowMicros()
+{
+    return InputQueue::now() / 1000;
+}
+
+void Session::startRecording(const string& path, const int width, const int height)
+{
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw runtime_error("Failed to create session recording " + path);
+    }
+    buffer.reserve(flushThreshold * 2);
+    buffer.assign(begin(magic), end(magic));
+    writeVarint(width);
+    writeVarint(height);
+    lastTimestamp = nowMicros();
+}
+
+void Session::stopRecording()
+{
+    if (fd < 0) return;
+    flush();
+    close(fd);
+    fd = -1;
+}
+
+bool Session::isRecording()
+{
+    return fd >= 0;
+}
+
+void Session::recordKey(const int key, const int scancode, const int action, const int mods)
+{
+    if (fd < 0) return;
+    beginEvent(EventType::Key);
+    writeVarint(zigzag(key));
+    writeVarint(zigzag(scancode));
+    writeVarint(action);
+    writeVarint(mods);
+}
+
+void Session::recordResize(const int width, const int height)
+{
+    if (fd < 0) return;
+    beginEvent(EventType::Resize);
+    writeVarint(width);
+    writeVarint(height);
+}
+
+void Session::recordFrame()
+{
+    if (fd < 0) return;
+    beginEvent(EventType::Frame);
+    if (buffer.size() >= flushThreshold) flush();
+}
+
+void Session::beginEvent(const EventType type)
+{
+    const uint64_t timestamp = nowMicros();
+    buffer.push_back(static_cast<uint8_t>(type));
+    writeVarint(timestamp - lastTimestamp);
+    lastTimestamp = timestamp;
+}
+
+void Session::writeVarint(uint64_t value)
+{
+    do
+    {
+        buffer.push_back(static_cast<uint8_t>((value & 0x7F) | (value > 0x7F ? 0x80 : 0)));
+        value >>= 7;
+    } while (value != 0);
+}
+
+void Session::flush()
+{
+    for (size_t written = 0; written < buffer.size();)
+    {
+        const ssize_t bytes = write(fd, buffer.data() + written, buffer.size() - written);
+        if (bytes <= 0) break;
+        written += static_cast<size_t>(bytes);
+    }
+    buffer.clear();
+}
+
+SessionReplay::SessionReplay(const string& path)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+    {
+        throw runtime_error("Failed to open session recording " + path);
+    }
+    data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    if (data.size() < sizeof(magic) || memcmp(data.data(), magic, sizeof(magic)) != 0)
+    {
+        throw runtime_error("Not a session recording: " + path);
+    }
+    offset = sizeof(magic);
+    width = static_cast<int>(readVarint());
+    height = static_cast<int>(readVarint());
+}
+
+bool SessionReplay::dispatchFrame(RenderBackend& backend, const bool realtime)
+{
+    if (startTime == 0) startTime = nowMicros();
+
+    while (offset < data.size())
+    {
+        const auto type = static_cast<Session::EventType>(data[offset++]);
+        recordedTime += readVarint();
+
+        if (realtime)
+        {
+            const uint64_t target = startTime + recordedTime;
+            if (const uint64_t now = nowMicros(); now < target)
+            {
+                this_thread::sleep_for(chrono::microseconds(target - now));
+            }
+        }
+
+        switch (type)
+        {
+        case Session::EventType::Key:
+        {
+            const auto key = static_cast<int>(unzigzag(readVarint()));
+            const auto scancode = static_cast<int>(unzigzag(readVarint()));
+            const auto action = static_cast<int>(readVarint());
+            const auto mods = static_cast<int>(readVarint());
+            keyCallback(nullptr, key, scancode, action, mods);
+            break;
+        }
+        case Session::EventType::Resize:
+        {
+            const auto newWidth = static_cast<int>(readVarint());
+            const auto newHeight = static_cast<int>(readVarint());
+            backend.resize(newWidth, newHeight);
+            break;
+        }
+        case Session::EventType::Frame:
+            frames++;
+            return true;
+        default:
+            throw runtime_error("Corrupt session recording");
+        }
+    }
+    return false;
+}
+
+int SessionReplay::getWidth() const
+{
+    return width;
+}
+
+int SessionReplay::getHeight() const
+{
+    return height;
+}
+
+uint64_t SessionReplay::getFrames() const
+{
+    return frames;
+}
+
+bool SessionReplay::isFinished() const
+{
+    return offset >= data.size();
+}
+
+uint64_t SessionReplay::readVarint()
+{
+    uint64_t value = 0;
+    for (int shift = 0; offset < data.size(); shift += 7)
+    {
+        if (shift >= 64) throw runtime_error("Corrupt session recording");
+        const uint8_t byte = data[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
@@ -0,0 +1,107 @@
+#include "sevensegmentdisplay/SoftwareRenderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static uint32_t materialColor(const vec3 color)
+{
+    return color == vec3(1.0f, 0.0f, 0.0f) ? SoftwareRenderer::onColor : SoftwareRenderer::offColor;
+}
+
+// Scanline fill of a convex polygon, sampling pixel centers
+static void fillConvex(vector<uint32_t>& pixels, const int width, const int height, const float scale,
+                       const vector<vec2>& polygon, const uint32_t color)
+{
+    float minY = polygon[0].y, maxY = polygon[0].y;
+    for (const auto& p : polygon)
+    {
+        minY = min(minY, p.y);
+        maxY = max(maxY, p.y);
+    }
+    const int firstRow = max(0, static_cast<int>(ceil(minY / scale - 0.5f)));
+    const int lastRow = min(height - 1, static_cast<int>(floor(maxY / scale - 0.5f)));
+
+    for (int y = firstRow; y <= lastRow; ++y)
+    {
+        const float sampleY = (y + 0.5f) * scale;
+        float left = INFINITY, right = -INFINITY;
+        for (size_t i = 0; i < polygon.size(); ++i)
+        {
+            const vec2 a = polygon[i];
+            const vec2 b = polygon[(i + 1) % polygon.size()];
+            if ((a.y <= sampleY) == (b.y <= sampleY)) continue;
+            const float x = a.x + (sampleY - a.y) / (b.y - a.y) * (b.x - a.x);
+            left = min(left, x);
+            right = max(right, x);
+        }
+        if (left > right) continue;
+        const int firstColumn = max(0, static_cast<int>(ceil(left / scale - 0.5f)));
+        const int lastColumn = min(width - 1, static_cast<int>(floor(right / scale - 0.5f)));
+        if (firstColumn > lastColumn) continue;
+        fill_n(pixels.begin() + y * width + firstColumn, lastColumn - firstColumn + 1, color);
+    }
+}
+
+SoftwareRenderer::SoftwareRenderer(const RenderSettings& settings)
+    : width(settings.width), height(settings.height), pixels(static_cast<size_t>(width) * height)
+{
+}
+
+void SoftwareRenderer::rasterize(const Scene& scene, vector<uint32_t>& pixels, const int width, const int height, const float scale)
+{
+    pixels.assign(static_cast<size_t>(width) * height, backgroundColor);
+    for (const auto& [points, color] : scene.segments)
+    {
+        fillConvex(pixels, width, height, scale, points, materialColor(color));
+    }
+    for (const auto& [points, color] : scene.indicators)
+    {
+        fillConvex(pixels, width, height, scale, points, materialColor(color));
+    }
+}
+
+void SoftwareRenderer::drawFrame(const Scene& scene)
+{
+    rasterize(scene, pixels, width, height, 1.0f);
+}
+
+void SoftwareRenderer::present()
+{
+}
+
+void SoftwareRenderer::pollEvents()
+{
+}
+
+void SoftwareRenderer::resize(const int newWidth, const int newHeight)
+{
+    width = newWidth;
+    height = newHeight;
+}
+
+bool SoftwareRenderer::isOpen() const
+{
+    return true;
+}
+
+vec2 SoftwareRenderer::getScreenSize() const
+{
+    return vec2(width, height);
+}
+
+const char* SoftwareRenderer::getName() const
+{
+    return "software";
+}
+
+const char* SoftwareRenderer::getReducedWorkload() const
+{
+    return "flat colors, no noise background, glow or bloom";
+}
+
+const vector<uint32_t>& SoftwareRenderer::getPixels() const
+{
+    return pixels;
+}
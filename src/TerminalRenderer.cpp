@@ -0,0 +1,226 @@
+#include "sevensegmentdisplay/TerminalRenderer.hpp"
+#include "sevensegmentdisplay/SoftwareRenderer.hpp"
+#include "sevensegmentdisplay/Renderer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+using namespace std;
+
+static volatile sig_atomic_t resized = 0;
+
+static void onResize(int)
+{
+    resized = 1;
+}
+
+static void appendColor(string& out, const char* prefix, const uint32_t rgb)
+{
+    out += prefix;
+    out += to_string(rgb >> 16);
+    out += ';';
+    out += to_string(rgb >> 8 & 0xFF);
+    out += ';';
+    out += to_string(rgb & 0xFF);
+    out += 'm';
+}
+
+TerminalRenderer::TerminalRenderer(const RenderSettings& settings)
+    : frameInterval(1000000 / max(1, settings.terminalFps)), nextFrame(std::chrono::steady_clock::now())
+{
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &savedTermios) == 0)
+    {
+        termios raw = savedTermios;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        rawMode = true;
+    }
+    signal(SIGWINCH, onResize);
+
+    // Alternate screen, hidden cursor
+    output = "\x1b[?1049h\x1b[?25l";
+    querySize();
+}
+
+TerminalRenderer::~TerminalRenderer()
+{
+    output += "\x1b[0m\x1b[?25h\x1b[?1049l";
+    flush();
+    if (rawMode) tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios);
+}
+
+void TerminalRenderer::querySize()
+{
+    if (winsize size{}; ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0)
+    {
+        columns = size.ws_col;
+        rows = size.ws_row;
+    }
+    cells.assign(static_cast<size_t>(columns) * rows, 0);
+    // Nothing on screen matches this, so the next frame redraws every cell
+    previousCells.assign(cells.size(), ~0ull);
+    output += "\x1b[0m\x1b[2J";
+}
+
+vec2 TerminalRenderer::getScreenSize() const
+{
+    return {columns * pixelScale, rows * 2 * pixelScale};
+}
+
+void TerminalRenderer::drawFrame(const Scene& scene)
+{
+    if (resized)
+    {
+        resized = 0;
+        querySize();
+    }
+
+    SoftwareRenderer::rasterize(scene, pixels, columns, rows * 2, pixelScale);
+
+    uint32_t currentFg = ~0u, currentBg = ~0u;
+    int cursorRow = -1, cursorColumn = -1;
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int column = 0; column < columns; ++column)
+        {
+            const size_t index = row * columns + column;
+            const uint32_t top = pixels[row * 2 * columns + column];
+            const uint32_t bottom = pixels[(row * 2 + 1) * columns + column];
+            cells[index] = static_cast<uint64_t>(top) << 32 | bottom;
+            if (cells[index] == previousCells[index]) continue;
+
+            if (row != cursorRow || column != cursorColumn)
+            {
+                output += "\x1b[" + to_string(row + 1) + ";" + to_string(column + 1) + "H";
+            }
+            if (top == bottom)
+            {
+                // A plain space only needs the background color
+                if (bottom != currentBg) appendColor(output, "\x1b[48;2;", currentBg = bottom);
+                output += ' ';
+            }
+            else
+            {
+                if (top != currentFg) appendColor(output, "\x1b[38;2;", currentFg = top);
+                if (bottom != currentBg) appendColor(output, "\x1b[48;2;", currentBg = bottom);
+                output += "▀";
+            }
+            cursorRow = row;
+            cursorColumn = column + 1;
+        }
+    }
+    if (flush())
+    {
+        previousCells.swap(cells);
+    }
+    else
+    {
+        // Part of the frame never reached the terminal, so nothing on screen can be trusted
+        fill(previousCells.begin(), previousCells.end(), ~0ull);
+    }
+}
+
+void TerminalRenderer::present()
+{
+    nextFrame += frameInterval;
+    this_thread::sleep_until(nextFrame);
+}
+
+void TerminalRenderer::resize(int, int)
+{
+    // The terminal's own size always wins
+    querySize();
+}
+
+const char* TerminalRenderer::getName() const
+{
+    return "terminal";
+}
+
+const char* TerminalRenderer::getReducedWorkload() const
+{
+    return "flat colors, no noise background, glow or bloom";
+}
+
+void TerminalRenderer::pollEvents()
+{
+    // stdin shares its file description with stdout on a terminal, so it is polled instead of made non-blocking
+    pollfd in{STDIN_FILENO, POLLIN, 0};
+    if (poll(&in, 1, 0) <= 0) return;
+    char input[64];
+    const ssize_t bytes = read(STDIN_FILENO, input, sizeof(input));
+    for (ssize_t i = 0; i < bytes; ++i)
+    {
+        const char c = input[i];
+        int key = -1;
+        if (c == 'q' || c == 'Q')
+        {
+            open = false;
+        }
+        else if (c >= '0' && c <= '9')
+        {
+            key = GLFW_KEY_0 + (c - '0');
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            key = GLFW_KEY_A + (c - 'a');
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            key = GLFW_KEY_A + (c - 'A');
+        }
+        else if (c == '\x1b' && i + 2 < bytes && input[i + 1] == 'O' && input[i + 2] >= 'P' && input[i + 2] <= 'S')
+        {
+            // xterm F1-F4: ESC O P..S
+            key = GLFW_KEY_F1 + (input[i + 2] - 'P');
+            i += 2;
+        }
+        else if (c == '\x1b' && i + 4 < bytes && input[i + 1] == '[' && input[i + 2] == '1' && input[i + 4] == '~' &&
+                 input[i + 3] >= '1' && input[i + 3] <= '4')
+        {
+            // VT220 F1-F4: ESC [ 1 1..4 ~
+            key = GLFW_KEY_F1 + (input[i + 3] - '1');
+            i += 4;
+        }
+        if (key >= 0) keyCallback(nullptr, key, 0, GLFW_PRESS, 0);
+    }
+}
+
+bool TerminalRenderer::isOpen() const
+{
+    return open;
+}
+
+uint64_t TerminalRenderer::getBytesWritten() const
+{
+    return bytesWritten;
+}
+
+bool TerminalRenderer::flush()
+{
+    size_t written = 0;
+    while (written < output.size())
+    {
+        const ssize_t bytes = write(STDOUT_FILENO, output.data() + written, output.size() - written);
+        if (bytes > 0)
+        {
+            written += static_cast<size_t>(bytes);
+            continue;
+        }
+        if (bytes < 0 && errno == EINTR) continue;
+        // Another process may have made the terminal non-blocking; wait until it takes more
+        if (pollfd out{STDOUT_FILENO, POLLOUT, 0}; bytes < 0 && errno == EAGAIN && poll(&out, 1, -1) > 0) continue;
+        break;
+    }
+    bytesWritten += written;
+    const bool complete = written == output.size();
+    output.clear();
+    return complete;
+}
@@ -0,0 +1,250 @@
+#include "sevensegmentdisplay/ValueFeed.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+using namespace std;
+
+static void setNonBlocking(const int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static int hexDigit(const uint8_t c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return 10 + c - 'a';
+    if (c >= 'A' && c <= 'F') return 10 + c - 'A';
+    return -1;
+}
+
+ValueFeed::ValueFeed(const string& source)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || stopFd < 0)
+    {
+        throw runtime_error("Failed to create feed epoll instance");
+    }
+    epoll_event stopEvent{EPOLLIN, {.ptr = &stopFd}};
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &stopEvent) < 0)
+    {
+        throw runtime_error(string("Failed to watch feed stop event: ") + strerror(errno));
+    }
+
+    if (source == "stdin" || source == "-")
+    {
+        if (watchSource(STDIN_FILENO, "stdin"))
+        {
+            stdinFlags = fcntl(STDIN_FILENO, F_GETFL);
+            setNonBlocking(STDIN_FILENO);
+        }
+    }
+    else if (source.starts_with("fifo:"))
+    {
+        const string path = source.substr(5);
+        if (mkfifo(path.c_str(), 0600) < 0 && errno != EEXIST)
+        {
+            throw runtime_error("Failed to create FIFO " + path + ": " + strerror(errno));
+        }
+        // Opening read-write keeps the FIFO alive between writers instead of hitting EOF
+        const int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw runtime_error("Failed to open FIFO " + path + ": " + strerror(errno));
+        }
+        watchSource(fd, path);
+    }
+    else if (source.starts_with("unix:"))
+    {
+        socketPath = source.substr(5);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path))
+        {
+            throw runtime_error("UNIX socket path too long: " + socketPath);
+        }
+        memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(socketPath.c_str());
+        if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            listen(listenFd, static_cast<int>(maxConnections)) < 0)
+        {
+            throw runtime_error("Failed to listen on " + socketPath + ": " + strerror(errno));
+        }
+        ownsSocketPath = true;
+        epoll_event listenEvent{EPOLLIN, {.ptr = &listenFd}};
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &listenEvent) < 0)
+        {
+            throw runtime_error("Failed to watch " + socketPath + ": " + strerror(errno));
+        }
+    }
+    else
+    {
+        throw invalid_argument("Unknown feed source: " + source);
+    }
+
+    thread = std::thread(&ValueFeed::run, this);
+}
+
+ValueFeed::~ValueFeed()
+{
+    constexpr uint64_t one = 1;
+    stopping.store(true, memory_order_relaxed);
+    write(stopFd, &one, sizeof(one));
+    if (thread.joinable()) thread.join();
+
+    for (auto& connection : connections)
+    {
+        if (connection.fd >= 0) closeConnection(connection);
+    }
+    if (listenFd >= 0) close(listenFd);
+    if (ownsSocketPath) unlink(socketPath.c_str());
+    if (stdinFlags >= 0) fcntl(STDIN_FILENO, F_SETFL, stdinFlags);
+    close(stopFd);
+    close(epollFd);
+}
+
+bool ValueFeed::poll(uint8_t& value)
+{
+    const uint32_t current = latest.load(memory_order_acquire);
+    if (current >> 8 == lastSequence) return false;
+    lastSequence = current >> 8;
+    value = current & 0xFF;
+    return true;
+}
+
+uint64_t ValueFeed::getMessages() const
+{
+    return messages.load(memory_order_relaxed);
+}
+
+bool ValueFeed::addFd(const int fd)
+{
+    for (auto& connection : connections)
+    {
+        if (connection.fd < 0)
+        {
+            epoll_event event{EPOLLIN, {.ptr = &connection}};
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) return false;
+            connection = Parser{fd};
+            return true;
+        }
+    }
+    errno = EMFILE;
+    return false;
+}
+
+bool ValueFeed::watchSource(const int fd, const string& name)
+{
+    if (addFd(fd)) return true;
+    if (errno != EPERM) throw runtime_error("Failed to watch " + name + ": " + strerror(errno));
+    // epoll refuses regular files and /dev/null; reads from them never wait, so the feed thread reads them directly
+    connections[0] = Parser{fd};
+    unpolled = &connections[0];
+    return false;
+}
+
+void ValueFeed::closeConnection(Parser& parser)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, parser.fd, nullptr);
+    if (parser.fd != STDIN_FILENO) close(parser.fd);
+    parser.fd = -1;
+}
+
+void ValueFeed::run()
+{
+    if (unpolled && !drainFd(*unpolled)) closeConnection(*unpolled);
+
+    array<epoll_event, maxConnections + 2> events{};
+    while (true)
+    {
+        const int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+        if (ready < 0 && errno != EINTR) return;
+
+        for (int i = 0; i < ready; ++i)
+        {
+            if (events[i].data.ptr == &stopFd) return;
+
+            if (events[i].data.ptr == &listenFd)
+            {
+                int client;
+                while ((client = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                {
+                    if (!addFd(client)) close(client);
+                }
+                continue;
+            }
+
+            auto& parser = *static_cast<Parser*>(events[i].data.ptr);
+            if (!drainFd(parser)) closeConnection(parser);
+        }
+    }
+}
+
+bool ValueFeed::drainFd(Parser& parser)
+{
+    while (!stopping.load(memory_order_relaxed))
+    {
+        const ssize_t bytes = read(parser.fd, buffer.data(), buffer.size());
+        if (bytes == 0) return false;
+        if (bytes < 0) return errno == EAGAIN || errno == EINTR;
+
+        // Publish once per batch; the renderer only ever needs the latest value
+        if (uint8_t value; parse(parser, buffer.data(), static_cast<size_t>(bytes), value))
+        {
+            const uint32_t sequence = (latest.load(memory_order_relaxed) >> 8) + 1;
+            latest.store(sequence << 8 | value, memory_order_release);
+        }
+    }
+    return true;
+}
+
+bool ValueFeed::parse(Parser& parser, const uint8_t* data, const size_t size, uint8_t& value)
+{
+    uint64_t parsed = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        const uint8_t c = data[i];
+        if (parser.expectBinary)
+        {
+            parser.expectBinary = false;
+            value = c & 0xF;
+            parsed++;
+        }
+        else if (c == frameMarker)
+        {
+            parser.expectBinary = true;
+            parser.inText = false;
+        }
+        else if (const int digit = hexDigit(c); digit >= 0)
+        {
+            parser.textValue = static_cast<uint8_t>(parser.textValue << 4 | digit);
+            parser.inText = true;
+        }
+        else if (c == 'x' || c == 'X')
+        {
+            // "0x" prefix
+            parser.textValue = 0;
+        }
+        else if (parser.inText)
+        {
+            // Any separator ends a text value
+            value = parser.textValue & 0xF;
+            parser.textValue = 0;
+            parser.inText = false;
+            parsed++;
+        }
+    }
+    messages.fetch_add(parsed, memory_order_relaxed);
+    return parsed > 0;
+}
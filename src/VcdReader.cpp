@@ -0,0 +1,316 @@
+#include "sevensegmentdisplay/VcdReader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static bool isSpace(const char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Returns the next whitespace-separated token at or after offset and moves offset past it
+static string_view nextToken(const char* data, const size_t size, size_t& offset)
+{
+    while (offset < size && isSpace(data[offset])) offset++;
+    const size_t start = offset;
+    while (offset < size && !isSpace(data[offset])) offset++;
+    return {data + start, offset - start};
+}
+
+static uint8_t vectorValue(const string_view bits)
+{
+    // MSB first; x and z read as 0, only the low nibble reaches the display
+    uint8_t value = 0;
+    for (size_t i = bits.size() > 4 ? bits.size() - 4 : 0; i < bits.size(); ++i)
+    {
+        value = static_cast<uint8_t>(value << 1 | (bits[i] == '1'));
+    }
+    return value & 0xF;
+}
+
+VcdReader::VcdReader(const string& path, const string& signal, const bool indexed)
+{
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw runtime_error("Failed to open VCD file " + path);
+    }
+    struct stat info{};
+    fstat(fd, &info);
+    size = static_cast<size_t>(info.st_size);
+    void* mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (mapping == MAP_FAILED)
+    {
+        close(fd);
+        throw runtime_error("Failed to map VCD file " + path);
+    }
+    data = static_cast<const char*>(mapping);
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    try
+    {
+        parseHeader(signal);
+    }
+    catch (...)
+    {
+        munmap(mapping, size);
+        close(fd);
+        throw;
+    }
+
+    cursor.offset = bodyOffset;
+    checkpoints.push_back(cursor);
+    if (indexed) indexer = thread(&VcdReader::buildIndex, this);
+    else indexComplete = true;
+}
+
+VcdReader::~VcdReader()
+{
+    stopIndexing = true;
+    if (indexer.joinable()) indexer.join();
+    munmap(const_cast<char*>(data), size);
+    close(fd);
+}
+
+void VcdReader::parseHeader(const string& signal)
+{
+    vector<string_view> scopes;
+    size_t offset = 0;
+    while (offset < size)
+    {
+        const string_view token = nextToken(data, size, offset);
+        if (token == "$enddefinitions")
+        {
+            nextToken(data, size, offset); // $end
+            bodyOffset = offset;
+            break;
+        }
+        if (token == "$timescale")
+        {
+            const size_t start = static_cast<size_t>(token.data() - data);
+            string text;
+            for (string_view part = nextToken(data, size, offset); !part.empty() && part != "$end"; part = nextToken(data, size, offset))
+            {
+                text += part;
+            }
+            const size_t digits = min(text.find_first_not_of("0123456789"), text.size());
+            const string unit = digits == text.size() ? "s" : text.substr(digits);
+            constexpr pair<string_view, double> units[] = {{"s", 1}, {"ms", 1e-3}, {"us", 1e-6}, {"ns", 1e-9}, {"ps", 1e-12}, {"fs", 1e-15}};
+            const auto found = find_if(begin(units), end(units), [&](const auto& entry) { return entry.first == unit; });
+            // The magnitude is 1, 10 or 100 in practice; the digit limit keeps stod in range
+            const double magnitude = digits == 0 || digits > 9 ? 1.0 : stod(text.substr(0, digits));
+            if (text.empty() || digits > 9 || magnitude == 0 || found == end(units))
+            {
+                throw runtime_error("VCD file has a malformed $timescale at offset " + to_string(start));
+            }
+            timescale = magnitude * found->second;
+        }
+        else if (token == "$scope")
+        {
+            nextToken(data, size, offset); // scope type
+            scopes.push_back(nextToken(data, size, offset));
+            nextToken(data, size, offset); // $end
+        }
+        else if (token == "$upscope")
+        {
+            if (!scopes.empty()) scopes.pop_back();
+            nextToken(data, size, offset);
+        }
+        else if (token == "$var")
+        {
+            nextToken(data, size, offset); // var type
+            const int varWidth = stoi(string(nextToken(data, size, offset)));
+            const string_view code = nextToken(data, size, offset);
+            const string_view name = nextToken(data, size, offset);
+            while (offset < size && nextToken(data, size, offset) != "$end") {}
+
+            string fullName;
+            for (const auto& scope : scopes)
+            {
+                fullName.append(scope).append(".");
+            }
+            fullName.append(name);
+            if (identifier.empty() && (signal == name || signal == fullName))
+            {
+                identifier = code;
+                width = varWidth;
+            }
+        }
+        else if (token.starts_with("$") && token != "$end")
+        {
+            // $date, $version, $comment, ...: skip the body
+            while (offset < size && nextToken(data, size, offset) != "$end") {}
+        }
+    }
+
+    if (bodyOffset == 0)
+    {
+        throw runtime_error("VCD file has no $enddefinitions");
+    }
+    if (identifier.empty())
+    {
+        throw runtime_error("VCD signal not found: " + signal);
+    }
+}
+
+void VcdReader::scan(Cursor& state, const uint64_t targetTime, const size_t offsetLimit, vector<Change>* changes) const
+{
+    size_t offset = state.offset;
+    while (offset < size)
+    {
+        const size_t tokenStart = offset;
+        const string_view token = nextToken(data, size, offset);
+        if (token.empty()) break;
+
+        switch (token[0])
+        {
+        case '#':
+        {
+            uint64_t time = 0;
+            for (size_t i = 1; i < token.size(); ++i) time = time * 10 + (token[i] - '0');
+            if (time > targetTime || tokenStart >= offsetLimit)
+            {
+                // Leave the timestamp unconsumed so the cursor stays on a time boundary
+                state.offset = tokenStart;
+                return;
+            }
+            state.time = time;
+            break;
+        }
+        case 'b':
+        case 'B':
+        {
+            if (const string_view code = nextToken(data, size, offset); code == identifier)
+            {
+                state.value = vectorValue(token.substr(1));
+                if (changes) changes->push_back({state.time, state.value});
+            }
+            break;
+        }
+        case 'r':
+        case 'R':
+            nextToken(data, size, offset); // real values never drive the display
+            break;
+        case '$':
+            if (token == "$comment")
+            {
+                while (offset < size && nextToken(data, size, offset) != "$end") {}
+            }
+            break;
+        default:
+            // Scalar change: value character immediately followed by the identifier code
+            if (token.substr(1) == identifier)
+            {
+                state.value = token[0] == '1';
+                if (changes) changes->push_back({state.time, state.value});
+            }
+            break;
+        }
+    }
+    state.offset = size;
+}
+
+void VcdReader::buildIndex()
+{
+    Cursor state = checkpoints.front();
+    while (!stopIndexing && state.offset < size)
+    {
+        scan(state, numeric_limits<uint64_t>::max(), state.offset + checkpointInterval);
+        {
+            lock_guard lock(indexMutex);
+            checkpoints.push_back(state);
+        }
+        checkpointAdded.notify_all();
+    }
+    {
+        lock_guard lock(indexMutex);
+        indexComplete = true;
+    }
+    checkpointAdded.notify_all();
+}
+
+void VcdReader::seek(const uint64_t time)
+{
+    {
+        // Waiting for the indexer to pass the target costs no more than scanning there, and never reads the file twice
+        unique_lock lock(indexMutex);
+        checkpointAdded.wait(lock, [&] { return indexComplete || checkpoints.back().time > time; });
+        auto next = upper_bound(checkpoints.begin(), checkpoints.end(), time,
+                                [](const uint64_t t, const Cursor& checkpoint) { return t < checkpoint.time; });
+        cursor = *prev(next == checkpoints.begin() ? next + 1 : next);
+    }
+    scan(cursor, time, numeric_limits<size_t>::max());
+}
+
+bool VcdReader::advanceTo(const uint64_t time)
+{
+    const uint8_t previous = cursor.value;
+    if (time >= cursor.time) scan(cursor, time, numeric_limits<size_t>::max());
+    return cursor.value != previous;
+}
+
+uint8_t VcdReader::getValue() const
+{
+    return cursor.value;
+}
+
+uint64_t VcdReader::getTime() const
+{
+    return cursor.time;
+}
+
+bool VcdReader::isFinished() const
+{
+    return cursor.offset >= size;
+}
+
+double VcdReader::getTimescale() const
+{
+    return timescale;
+}
+
+int VcdReader::getWidth() const
+{
+    return width;
+}
+
+size_t VcdReader::getBodyOffset() const
+{
+    return bodyOffset;
+}
+
+size_t VcdReader::getSize() const
+{
+    return size;
+}
+
+size_t VcdReader::findTimeBoundary(size_t offset) const
+{
+    // A timestamp always starts a line, so "\n#" marks a point where parsing can resume independently
+    while (offset < size)
+    {
+        const auto* hit = static_cast<const char*>(memchr(data + offset, '#', size - offset));
+        if (!hit) return size;
+        offset = static_cast<size_t>(hit - data);
+        if (offset == 0 || data[offset - 1] == '\n') return offset;
+        offset++;
+    }
+    return size;
+}
+
+uint64_t VcdReader::collectChanges(const size_t begin, const size_t end, vector<Change>& changes) const
+{
+    Cursor state{begin};
+    scan(state, numeric_limits<uint64_t>::max(), end, &changes);
+    return state.time;
+}
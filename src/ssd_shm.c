@@ -0,0 +1,112 @@
+#include <sevensegmentdisplay/ssd_shm.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int ssd_shm_open(ssd_shm* shm, const char* name, int create) {
+    memset(shm, 0, sizeof(*shm));
+    shm->fd = -1;
+    if(name == NULL) name = SSD_SHM_DEFAULT_NAME;
+    strncpy(shm->name, name, sizeof(shm->name) - 1);
+
+    shm->fd = shm_open(shm->name, create ? O_RDWR | O_CREAT : O_RDWR, 0600);
+    if(shm->fd < 0) return -1;
+    if(create && ftruncate(shm->fd, sizeof(ssd_display_state)) < 0) {
+        ssd_shm_close(shm);
+        return -1;
+    }
+
+    void* mapping = mmap(NULL, sizeof(ssd_display_state), PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+    if(mapping == MAP_FAILED) {
+        ssd_shm_close(shm);
+        return -1;
+    }
+    shm->state = (ssd_display_state*)mapping;
+    shm->owner = create;
+
+    if(create) {
+        ssd_shm_begin_write(shm);
+        shm->state->version = SSD_SHM_VERSION;
+        shm->state->digit_count = 1;
+        shm->state->brightness = 1.0f;
+        memset(shm->state->digits, 0, sizeof(shm->state->digits));
+        memset(shm->state->segment_mask, 0, sizeof(shm->state->segment_mask));
+        memset(shm->state->segment_value, 0, sizeof(shm->state->segment_value));
+        ssd_shm_end_write(shm);
+        __atomic_store_n(&shm->state->magic, SSD_SHM_MAGIC, __ATOMIC_RELEASE);
+    } else if(__atomic_load_n(&shm->state->magic, __ATOMIC_ACQUIRE) != SSD_SHM_MAGIC ||
+              shm->state->version != SSD_SHM_VERSION) {
+        ssd_shm_close(shm);
+        return -1;
+    }
+    return 0;
+}
+
+void ssd_shm_close(ssd_shm* shm) {
+    if(shm->state != NULL) munmap(shm->state, sizeof(ssd_display_state));
+    if(shm->fd >= 0) close(shm->fd);
+    if(shm->owner) shm_unlink(shm->name);
+    shm->state = NULL;
+    shm->fd = -1;
+    shm->owner = 0;
+}
+
+void ssd_shm_begin_write(ssd_shm* shm) {
+    const uint32_t sequence = __atomic_load_n(&shm->state->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->state->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void ssd_shm_end_write(ssd_shm* shm) {
+    const uint32_t sequence = __atomic_load_n(&shm->state->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->state->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+void ssd_shm_set_digit(ssd_shm* shm, uint32_t index, uint8_t value) {
+    if(index >= SSD_SHM_MAX_DIGITS) return;
+    ssd_shm_begin_write(shm);
+    shm->state->digits[index] = value;
+    if(index >= shm->state->digit_count) shm->state->digit_count = index + 1;
+    ssd_shm_end_write(shm);
+}
+
+void ssd_shm_set_segments(ssd_shm* shm, uint32_t index, uint8_t mask, uint8_t value) {
+    if(index >= SSD_SHM_MAX_DIGITS) return;
+    ssd_shm_begin_write(shm);
+    shm->state->segment_mask[index] = mask;
+    shm->state->segment_value[index] = value;
+    ssd_shm_end_write(shm);
+}
+
+void ssd_shm_set_brightness(ssd_shm* shm, float brightness) {
+    ssd_shm_begin_write(shm);
+    shm->state->brightness = brightness;
+    ssd_shm_end_write(shm);
+}
+
+int ssd_shm_read(const ssd_shm* shm, uint32_t* last_sequence, ssd_display_state* out) {
+    const ssd_display_state* state = shm->state;
+    ssd_display_state snapshot;
+    for(int attempt = 0; attempt < SSD_SHM_READ_ATTEMPTS; ++attempt) {
+        const uint32_t before = __atomic_load_n(&state->sequence, __ATOMIC_ACQUIRE);
+        if(before == *last_sequence) return 0;
+        if(before & 1u) continue;
+
+        memcpy(&snapshot, state, sizeof(snapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if(__atomic_load_n(&state->sequence, __ATOMIC_RELAXED) == before) {
+            *last_sequence = before;
+            /* A consistent snapshot with bad contents is skipped, not retried */
+            if(!(snapshot.brightness >= 0.0f && snapshot.brightness <= 1.0f) ||
+               snapshot.digit_count > SSD_SHM_MAX_DIGITS) return 0;
+            memcpy(out, &snapshot, sizeof(*out));
+            return 1;
+        }
+    }
+    /* A producer is mid-write, or died there; try again next frame */
+    return 0;
+}
@@ -0,0 +1,77 @@
+/*
+    Throughput test for the shared-memory display interface.
+
+    Usage: ssd_shm_bench [updates] [name]
+
+    Creates its own segment unless the display already owns it, then writes the given number of
+    updates while a reader thread takes snapshots and checks that none of them is torn.
+*/
+
+#include <sevensegmentdisplay/ssd_shm.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static volatile int done;
+static unsigned long long reads, torn;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void* reader(void* arg) {
+    const ssd_shm* shm = (const ssd_shm*)arg;
+    ssd_display_state snapshot;
+    uint32_t sequence = 0;
+    while(!done) {
+        if(!ssd_shm_read(shm, &sequence, &snapshot)) continue;
+        reads++;
+        /* The writer always stores the same value in every digit and both segment arrays */
+        for(int i = 1; i < SSD_SHM_MAX_DIGITS; ++i) {
+            if(snapshot.digits[i] != snapshot.digits[0] || snapshot.segment_value[i] != snapshot.digits[0]) {
+                torn++;
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    const unsigned long long updates = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000ull;
+    const char* name = argc > 2 ? argv[2] : "/sevensegmentdisplay-bench";
+
+    ssd_shm shm;
+    if(ssd_shm_open(&shm, name, 0) != 0 && ssd_shm_open(&shm, name, 1) != 0) {
+        fprintf(stderr, "Failed to open shared memory segment %s\n", name);
+        return 1;
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, reader, &shm);
+
+    const double start = now_seconds();
+    for(unsigned long long i = 0; i < updates; ++i) {
+        const uint8_t value = (uint8_t)(i & 0xF);
+        ssd_shm_begin_write(&shm);
+        for(int d = 0; d < SSD_SHM_MAX_DIGITS; ++d) {
+            shm.state->digits[d] = value;
+            shm.state->segment_value[d] = value;
+        }
+        ssd_shm_end_write(&shm);
+    }
+    const double elapsed = now_seconds() - start;
+
+    done = 1;
+    pthread_join(thread, NULL);
+
+    printf("%llu updates in %.3f s: %.1f M updates/s\n", updates, elapsed, (double)updates / elapsed * 1e-6);
+    printf("%llu snapshots read, %llu torn\n", reads, torn);
+
+    ssd_shm_close(&shm);
+    return torn == 0 ? 0 : 1;
+}